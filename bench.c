@@ -0,0 +1,386 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "commands.h"
+#include "canvas.h"
+#include "input.h"
+
+#define DRAW_BENCH_SIZE 2000
+#define DRAW_BENCH_LINES 2000
+#define BENCH_RUNS 5
+#define LAYOUT_BENCH_CELLS 4000000
+#define LAYOUT_BENCH_EDITS 200
+
+typedef bool (*draw_function)(point firstPoint, point secondPoint, canvas* currentCanvas);
+
+// a canvas stored column by column (the transpose of canvas), only as far as the layout benchmark needs it
+typedef struct column_canvas_struct{
+    int num_rows;
+    int num_cols;
+    char** columns;
+} column_canvas;
+
+/**
+ * Draws a horizontal line the way draw_horizontal_line did before it was generated by DEFINE_DRAW_LINE, indexing pixels again for every read and write
+ * @param firstPoint : point struct representing the left end of the line
+ * @param secondPoint : point struct representing the right end of the line
+ * @param currentCanvas : pointer to canvas struct representing the canvas to draw on
+ * @return true if the line was drawn, false if there was not enough memory
+ * @modifies currentCanvas
+ */
+static bool handwritten_horizontal_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
+    if (get_writable_row(currentCanvas, currentCanvas->num_rows - firstPoint.y - 1) == NULL) return false;
+    for (int c = firstPoint.x; c <= secondPoint.x; c++) {
+        if (currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] == BACKGROUND) currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] = '-';
+        else if (currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] != '-') currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] = '+';
+    }
+    mark_row_changed(currentCanvas, currentCanvas->num_rows - firstPoint.y - 1);
+    return true;
+}
+
+/**
+ * Draws a vertical line the way draw_vertical_line did before it was generated by DEFINE_DRAW_LINE
+ * @param firstPoint : point struct representing the bottom end of the line
+ * @param secondPoint : point struct representing the top end of the line
+ * @param currentCanvas : pointer to canvas struct representing the canvas to draw on
+ * @return true if the line was drawn, false if there was not enough memory
+ * @modifies currentCanvas
+ */
+static bool handwritten_vertical_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
+    for (int r = firstPoint.y; r <= secondPoint.y; r++) {
+        if (get_writable_row(currentCanvas, currentCanvas->num_rows - r - 1) == NULL) return false;
+    }
+    for (int r = firstPoint.y; r <= secondPoint.y; r++) {
+        if (currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] == BACKGROUND) currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] = '|';
+        else if (currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] != '|') currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] = '+';
+        mark_row_changed(currentCanvas, currentCanvas->num_rows - r - 1);
+    }
+    return true;
+}
+
+/**
+ * Draws a left diagonal line the way draw_left_diagonal_line did before it was generated by DEFINE_DRAW_LINE
+ * @param firstPoint : point struct representing the lower left end of the line
+ * @param secondPoint : point struct representing the upper right end of the line
+ * @param currentCanvas : pointer to canvas struct representing the canvas to draw on
+ * @return true if the line was drawn, false if there was not enough memory
+ * @modifies currentCanvas
+ */
+static bool handwritten_left_diagonal_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
+    for (int r = firstPoint.y; r <= secondPoint.y; r++) {
+        if (get_writable_row(currentCanvas, currentCanvas->num_rows - r - 1) == NULL) return false;
+    }
+    int i = firstPoint.y;
+    for (int c = firstPoint.x; c <= secondPoint.x; c++) {
+        if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] == BACKGROUND) currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '/';
+        else if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] != '/') currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '+';
+        mark_row_changed(currentCanvas, currentCanvas->num_rows - i - 1);
+        i++;
+    }
+    return true;
+}
+
+/**
+ * Draws a right diagonal line the way draw_right_diagonal_line did before it was generated by DEFINE_DRAW_LINE
+ * @param firstPoint : point struct representing the upper left end of the line
+ * @param secondPoint : point struct representing the lower right end of the line
+ * @param currentCanvas : pointer to canvas struct representing the canvas to draw on
+ * @return true if the line was drawn, false if there was not enough memory
+ * @modifies currentCanvas
+ */
+static bool handwritten_right_diagonal_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
+    for (int r = secondPoint.y; r <= firstPoint.y; r++) {
+        if (get_writable_row(currentCanvas, currentCanvas->num_rows - r - 1) == NULL) return false;
+    }
+    int i = firstPoint.y;
+    for (int c = firstPoint.x; c <= secondPoint.x; c++) {
+        if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] == BACKGROUND) currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '\\';
+        else if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] != '\\') currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '+';
+        mark_row_changed(currentCanvas, currentCanvas->num_rows - i - 1);
+        i--;
+    }
+    return true;
+}
+
+/**
+ * Works out the ends of the i-th line of a kind drawn by the draw benchmark, lines of one kind being spread over the canvas
+ * @param kind : char representing the kind of line, 'H', 'V', 'L' or 'R' like type_of_line
+ * @param i : int representing which line it is
+ * @param firstPoint : pointer to point struct set to the end of the line the draw functions start from
+ * @param secondPoint : pointer to point struct set to the other end of the line
+ * @return nothing
+ * @modifies firstPoint, secondPoint
+ */
+static void bench_line(char kind, int i, point* firstPoint, point* secondPoint) {
+    int half = DRAW_BENCH_SIZE / 2;
+    int offset = i % half;
+    if (kind == 'H') {
+        *firstPoint = create_point(0, i % DRAW_BENCH_SIZE);
+        *secondPoint = create_point(DRAW_BENCH_SIZE - 1, i % DRAW_BENCH_SIZE);
+    }
+    else if (kind == 'V') {
+        *firstPoint = create_point(i % DRAW_BENCH_SIZE, 0);
+        *secondPoint = create_point(i % DRAW_BENCH_SIZE, DRAW_BENCH_SIZE - 1);
+    }
+    else if (kind == 'L') {
+        *firstPoint = create_point(offset, 0);
+        *secondPoint = create_point(offset + half - 1, half - 1);
+    }
+    else {
+        *firstPoint = create_point(offset, DRAW_BENCH_SIZE - 1);
+        *secondPoint = create_point(offset + half - 1, DRAW_BENCH_SIZE - half);
+    }
+}
+
+/**
+ * Times drawing DRAW_BENCH_LINES lines of one kind on a fresh DRAW_BENCH_SIZE by DRAW_BENCH_SIZE canvas
+ * @param draw : the function drawing the lines
+ * @param kind : char representing the kind of line, 'H', 'V', 'L' or 'R' like type_of_line
+ * @return the fastest of BENCH_RUNS runs, in seconds
+ */
+static double time_lines(draw_function draw, char kind) {
+    double best = -1;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        canvas benchCanvas = create_canvas(DRAW_BENCH_SIZE, DRAW_BENCH_SIZE);
+        point firstPoint, secondPoint;
+        clock_t start = clock();
+        for (int i = 0; i < DRAW_BENCH_LINES; i++) {
+            bench_line(kind, i, &firstPoint, &secondPoint);
+            draw(firstPoint, secondPoint, &benchCanvas);
+        }
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        free_canvas(&benchCanvas);
+        if (best < 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+/**
+ * Compares the draw functions generated by DEFINE_DRAW_LINE with the handwritten loops they replaced, without printing the canvas
+ * @param none : none
+ * @return nothing
+ * @modifies nothing
+ */
+static void bench_draw() {
+    char kinds[] = {'H', 'V', 'L', 'R'};
+    char* names[] = {"horizontal", "vertical", "left diagonal", "right diagonal"};
+    draw_function handwritten[] = {handwritten_horizontal_line, handwritten_vertical_line, handwritten_left_diagonal_line, handwritten_right_diagonal_line};
+    draw_function generated[] = {draw_horizontal_line_cells, draw_vertical_line_cells, draw_left_diagonal_line_cells, draw_right_diagonal_line_cells};
+    printf("Draw: %d lines of each kind on a %d X %d canvas, best of %d runs\n", DRAW_BENCH_LINES, DRAW_BENCH_SIZE, DRAW_BENCH_SIZE, BENCH_RUNS);
+    printf("%-16s %14s %14s\n", "line", "handwritten", "generated");
+    for (int k = 0; k < 4; k++) {
+        double handwrittenSeconds = time_lines(handwritten[k], kinds[k]);
+        double generatedSeconds = time_lines(generated[k], kinds[k]);
+        printf("%-16s %12.4f s %12.4f s\n", names[k], handwrittenSeconds, generatedSeconds);
+    }
+}
+
+/**
+ * Creates a column_canvas struct with every cell BACKGROUND
+ * @param num_rows : int representing number of rows for canvas
+ * @param num_cols : int representing number of columns for canvas
+ * @return the newly created column_canvas struct
+ */
+static column_canvas create_column_canvas(int num_rows, int num_cols) {
+    column_canvas columnCanvas;
+    columnCanvas.num_rows = num_rows;
+    columnCanvas.num_cols = num_cols;
+    columnCanvas.columns = (char**)malloc(num_cols * sizeof(char*));
+    for (int c = 0; c < num_cols; c++) {
+        columnCanvas.columns[c] = (char*)calloc(num_rows, sizeof(char));
+    }
+    return columnCanvas;
+}
+
+/**
+ * Frees all memory allocated for a column_canvas struct
+ * @param columnCanvas : pointer to column_canvas struct to free
+ * @return nothing
+ * @modifies frees memory from columnCanvas
+ */
+static void free_column_canvas(column_canvas* columnCanvas) {
+    for (int c = 0; c < columnCanvas->num_cols; c++) {
+        free(columnCanvas->columns[c]);
+    }
+    free(columnCanvas->columns);
+}
+
+/**
+ * Adds a column to a column_canvas, moving only column pointers like add_row does for rows
+ * @param columnCanvas : pointer to column_canvas struct to change
+ * @param colPos : int representing which column position (left-most being zero) to insert a new column
+ * @return nothing
+ * @modifies columnCanvas
+ */
+static void column_add_col(column_canvas* columnCanvas, int colPos) {
+    columnCanvas->columns = (char**)realloc(columnCanvas->columns, (columnCanvas->num_cols + 1) * sizeof(char*));
+    memmove(columnCanvas->columns + colPos + 1, columnCanvas->columns + colPos, (columnCanvas->num_cols - colPos) * sizeof(char*));
+    columnCanvas->columns[colPos] = (char*)calloc(columnCanvas->num_rows, sizeof(char));
+    columnCanvas->num_cols++;
+}
+
+/**
+ * Deletes a column from a column_canvas, moving only column pointers like delete_row does for rows
+ * @param columnCanvas : pointer to column_canvas struct to change
+ * @param colPos : int representing which column (left-most being zero) to delete
+ * @return nothing
+ * @modifies columnCanvas
+ */
+static void column_delete_col(column_canvas* columnCanvas, int colPos) {
+    free(columnCanvas->columns[colPos]);
+    memmove(columnCanvas->columns + colPos, columnCanvas->columns + colPos + 1, (columnCanvas->num_cols - colPos - 1) * sizeof(char*));
+    columnCanvas->num_cols--;
+}
+
+/**
+ * Adds a row to a column_canvas, growing and shifting every column like add_col does for rows
+ * @param columnCanvas : pointer to column_canvas struct to change
+ * @param rowPos : int representing which row position (bottom row being zero) to insert a new row
+ * @return nothing
+ * @modifies columnCanvas
+ */
+static void column_add_row(column_canvas* columnCanvas, int rowPos) {
+    for (int c = 0; c < columnCanvas->num_cols; c++) {
+        columnCanvas->columns[c] = (char*)realloc(columnCanvas->columns[c], columnCanvas->num_rows + 1);
+        memmove(columnCanvas->columns[c] + rowPos + 1, columnCanvas->columns[c] + rowPos, columnCanvas->num_rows - rowPos);
+        columnCanvas->columns[c][rowPos] = BACKGROUND;
+    }
+    columnCanvas->num_rows++;
+}
+
+/**
+ * Deletes a row from a column_canvas, shifting and shrinking every column like delete_col does for rows
+ * @param columnCanvas : pointer to column_canvas struct to change
+ * @param rowPos : int representing which row (bottom row being zero) to delete
+ * @return nothing
+ * @modifies columnCanvas
+ */
+static void column_delete_row(column_canvas* columnCanvas, int rowPos) {
+    for (int c = 0; c < columnCanvas->num_cols; c++) {
+        memmove(columnCanvas->columns[c] + rowPos, columnCanvas->columns[c] + rowPos + 1, columnCanvas->num_rows - rowPos - 1);
+        columnCanvas->columns[c] = (char*)realloc(columnCanvas->columns[c], columnCanvas->num_rows - 1);
+    }
+    columnCanvas->num_rows--;
+}
+
+/**
+ * Draws a line across a column_canvas, the cells of a vertical line being next to each other in memory
+ * @param columnCanvas : pointer to column_canvas struct to draw on
+ * @param vertical : true to draw column pos from bottom to top, false to draw row pos from left to right
+ * @param pos : int representing the column or row the line is drawn on
+ * @param glyph : char drawn on empty cells, cells holding another glyph become '+'
+ * @return nothing
+ * @modifies columnCanvas
+ */
+static void column_draw_line(column_canvas* columnCanvas, bool vertical, int pos, char glyph) {
+    int length = vertical ? columnCanvas->num_rows : columnCanvas->num_cols;
+    for (int i = 0; i < length; i++) {
+        char* pixel = vertical ? &columnCanvas->columns[pos][i] : &columnCanvas->columns[i][pos];
+        if (*pixel == BACKGROUND) *pixel = glyph;
+        else if (*pixel != glyph) *pixel = '+';
+    }
+}
+
+/**
+ * Times one kind of operation on a canvas and on a column_canvas of the same shape, with every row drawn on so no row is left unallocated
+ * @param operation : char representing the operation, 'c' for adding and deleting a column, 'r' for adding and deleting a row,
+ * 'V' for a vertical line and 'H' for a horizontal line
+ * @param num_rows : int representing number of rows of the canvases
+ * @param num_cols : int representing number of columns of the canvases
+ * @param rowMajorSeconds : pointer to double set to the time taken on the canvas
+ * @param columnMajorSeconds : pointer to double set to the time taken on the column_canvas
+ * @return nothing
+ * @modifies rowMajorSeconds, columnMajorSeconds
+ */
+static void time_layouts(char operation, int num_rows, int num_cols, double* rowMajorSeconds, double* columnMajorSeconds) {
+    *rowMajorSeconds = -1;
+    *columnMajorSeconds = -1;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        canvas rowCanvas = create_canvas(num_rows, num_cols);
+        column_canvas columnCanvas = create_column_canvas(num_rows, num_cols);
+        for (int y = 0; y < num_rows; y++) {
+            draw_horizontal_line_cells(create_point(0, y), create_point(num_cols - 1, y), &rowCanvas);
+            column_draw_line(&columnCanvas, false, y, '-');
+        }
+        clock_t start = clock();
+        for (int i = 0; i < LAYOUT_BENCH_EDITS; i++) {
+            if (operation == 'c') {
+                add_col(&rowCanvas, num_cols / 2);
+                delete_col(&rowCanvas, num_cols / 2);
+            }
+            else if (operation == 'r') {
+                add_row(&rowCanvas, num_rows / 2);
+                delete_row(&rowCanvas, num_rows / 2);
+            }
+            else if (operation == 'V') {
+                draw_vertical_line_cells(create_point(i % num_cols, 0), create_point(i % num_cols, num_rows - 1), &rowCanvas);
+            }
+            else {
+                draw_horizontal_line_cells(create_point(0, i % num_rows), create_point(num_cols - 1, i % num_rows), &rowCanvas);
+            }
+        }
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (*rowMajorSeconds < 0 || seconds < *rowMajorSeconds) *rowMajorSeconds = seconds;
+        start = clock();
+        for (int i = 0; i < LAYOUT_BENCH_EDITS; i++) {
+            if (operation == 'c') {
+                column_add_col(&columnCanvas, num_cols / 2);
+                column_delete_col(&columnCanvas, num_cols / 2);
+            }
+            else if (operation == 'r') {
+                column_add_row(&columnCanvas, num_rows / 2);
+                column_delete_row(&columnCanvas, num_rows / 2);
+            }
+            else if (operation == 'V') column_draw_line(&columnCanvas, true, i % num_cols, '|');
+            else column_draw_line(&columnCanvas, false, i % num_rows, '-');
+        }
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (*columnMajorSeconds < 0 || seconds < *columnMajorSeconds) *columnMajorSeconds = seconds;
+        free_canvas(&rowCanvas);
+        free_column_canvas(&columnCanvas);
+    }
+}
+
+/**
+ * Compares the row-major canvas with a column-major one on column edits, row edits and lines, for canvases of the same area and different shapes,
+ * and works out what share of edits must be column edits before column-major is faster
+ * @param none : none
+ * @return nothing
+ * @modifies nothing
+ */
+static void bench_layouts() {
+    int shapes[][2] = {{100, LAYOUT_BENCH_CELLS / 100}, {2000, LAYOUT_BENCH_CELLS / 2000}, {40000, LAYOUT_BENCH_CELLS / 40000}};
+    char operations[] = {'c', 'r', 'V', 'H'};
+    char* names[] = {"add+delete col", "add+delete row", "vertical line", "horizontal line"};
+    printf("\nLayouts: %d of each operation, every row drawn on, best of %d runs\n", LAYOUT_BENCH_EDITS, BENCH_RUNS);
+    printf("%-14s %-16s %14s %14s\n", "canvas", "operation", "row-major", "column-major");
+    for (int s = 0; s < 3; s++) {
+        double rowMajor[4], columnMajor[4];
+        char shape[32];
+        snprintf(shape, sizeof(shape), "%d X %d", shapes[s][0], shapes[s][1]);
+        for (int k = 0; k < 4; k++) {
+            time_layouts(operations[k], shapes[s][0], shapes[s][1], &rowMajor[k], &columnMajor[k]);
+            printf("%-14s %-16s %12.4f s %12.4f s\n", shape, names[k], rowMajor[k], columnMajor[k]);
+        }
+        // with a share f of column edits, row-major costs f * rowMajor[0] + (1 - f) * rowMajor[1], and likewise for column-major
+        double columnGain = rowMajor[0] - columnMajor[0];
+        double rowLoss = columnMajor[1] - rowMajor[1];
+        if (columnGain <= 0) printf("%-14s column-major is never faster for edits\n", shape);
+        else if (rowLoss <= 0) printf("%-14s column-major is always faster for edits\n", shape);
+        else printf("%-14s column-major is faster for edits when over %.1f%% are column edits\n", shape, 100 * rowLoss / (columnGain + rowLoss));
+    }
+}
+
+/**
+ * Times the canvas operations the optimizations were made for and prints the results (run with make bench)
+ * @param none : none
+ * @return 0
+ * @modifies nothing directly
+ */
+int main() {
+    bench_draw();
+    bench_layouts();
+    return 0;
+}
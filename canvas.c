@@ -1,33 +1,182 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "commands.h"
 #include "canvas.h"
 #include "input.h"
 
+static unsigned long version_clock = 0;
+static bool diff_output = false;
+static unsigned long printed_version = 0;
+static size_t saved_footprint = 0;
+static size_t peak_footprint = 0;
+static size_t memory_limit = 0;
+
 /**
  * Creates a new canvas struct with specified dimensions and initializes members
  * @param num_rows : int representing number of rows for canvas
  * @param num_cols : int represenitng number of columns for canvas
- * @return the newly created canvas struct 
+ * @return the newly created canvas struct, with 0 rows and columns if there was not enough memory for it
  */
 canvas create_canvas(int num_rows, int num_cols) {
     canvas canvasStruct;
     canvasStruct.num_rows = num_rows;
     canvasStruct.num_cols = num_cols;
-    canvasStruct.pixels = (char**)malloc(num_rows * sizeof(char*));
-    for (int i = 0; i < num_rows; i++) {
-        canvasStruct.pixels[i] = (char*)malloc(num_cols * sizeof(char));
+    canvasStruct.pixels = (char**)calloc(num_rows, sizeof(char*));
+    canvasStruct.row_shared = (bool*)calloc(num_rows, sizeof(bool));
+    canvasStruct.name = NULL;
+    canvasStruct.version = next_version();
+    canvasStruct.row_versions = (unsigned long*)malloc(num_rows * sizeof(unsigned long));
+    canvasStruct.segments = create_segment_index();
+    if (num_rows > 0 && (canvasStruct.pixels == NULL || canvasStruct.row_shared == NULL || canvasStruct.row_versions == NULL
+        || !resize_bucket_grid(&canvasStruct.segments, num_rows, num_cols))) {
+        free(canvasStruct.pixels);
+        free(canvasStruct.row_shared);
+        free(canvasStruct.row_versions);
+        free_segment_index(&canvasStruct.segments);
+        return create_canvas(0, 0);
     }
     for (int r = 0; r < num_rows; r++) {
-        for (int c = 0; c < num_cols; c++) {
-            canvasStruct.pixels[r][c] = '*';
-        }
+        canvasStruct.row_versions[r] = canvasStruct.version;
     }
     return canvasStruct;
 }   
 
+/**
+ * Creates a new canvas struct that shares every row of another canvas, copying only the small members and the segment index
+ * Rows are not copied until one of the canvases changes them (see get_writable_row)
+ * @param sourceCanvas : pointer to canvas struct representing the canvas to share
+ * @return the newly created canvas struct, which does not free the shared rows, or a canvas with 0 rows and columns if there was not enough memory for it
+ */
+canvas share_canvas(canvas* sourceCanvas) {
+    canvas canvasStruct = create_canvas(sourceCanvas->num_rows, sourceCanvas->num_cols);
+    if (canvasStruct.num_rows != sourceCanvas->num_rows) return canvasStruct;
+    free_segment_index(&canvasStruct.segments);
+    if (!copy_segment_index(&canvasStruct.segments, &sourceCanvas->segments)) {
+        free_canvas(&canvasStruct);
+        return create_canvas(0, 0);
+    }
+    for (int r = 0; r < sourceCanvas->num_rows; r++) {
+        canvasStruct.pixels[r] = sourceCanvas->pixels[r];
+        canvasStruct.row_shared[r] = true;
+    }
+    if (sourceCanvas->name != NULL) canvasStruct.name = strdup(sourceCanvas->name);
+    canvasStruct.version = sourceCanvas->version;
+    if (sourceCanvas->num_rows > 0) {
+        memcpy(canvasStruct.row_versions, sourceCanvas->row_versions, sourceCanvas->num_rows * sizeof(unsigned long));
+    }
+    return canvasStruct;
+}
+
+/**
+ * Freezes the current version of a "canvas" as a new canvas struct without copying its rows
+ * The snapshot takes over freeing the rows, and currentCanvas copies a row the first time it changes it afterwards
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @param name : string representing the name to give the snapshot
+ * @return the newly created canvas struct, with no name (and nothing changed) if there was not enough memory for it
+ * @modifies currentCanvas
+ */
+canvas snapshot_canvas(canvas* currentCanvas, char* name) {
+    canvas canvasStruct = share_canvas(currentCanvas);
+    free(canvasStruct.name);
+    canvasStruct.name = NULL;
+    if (canvasStruct.num_rows != currentCanvas->num_rows) return canvasStruct;
+    canvasStruct.name = strdup(name);
+    if (canvasStruct.name == NULL) return canvasStruct;
+    for (int r = 0; r < currentCanvas->num_rows; r++) {
+        canvasStruct.row_shared[r] = currentCanvas->row_shared[r];
+        currentCanvas->row_shared[r] = true;
+    }
+    // snapshots are kept until the program quits, so their memory only ever adds up
+    saved_footprint += canvas_footprint(&canvasStruct);
+    return canvasStruct;
+}
+
+/**
+ * Frees all memory allocated for the members of a canvas struct
+ * @param currentCanvas : pointer to canvas struct representing the canvas to free
+ * @return nothing
+ * @modifies frees memory from currentCanvas
+ */
+void free_canvas(canvas* currentCanvas) {
+    for (int r = 0; r < currentCanvas->num_rows; r++) {
+        if (!currentCanvas->row_shared[r]) free(currentCanvas->pixels[r]);
+    }
+    free(currentCanvas->pixels);
+    free(currentCanvas->row_shared);
+    free(currentCanvas->row_versions);
+    free(currentCanvas->name);
+    free_segment_index(&currentCanvas->segments);
+}
+
+/**
+ * Hands out the next version number, shared by all canvases so versions only ever increase within a session
+ * @param none : none
+ * @return an unsigned long greater than every version handed out before it
+ */
+unsigned long next_version() {
+    version_clock++;
+    return version_clock;
+}
+
+/**
+ * Stamps a row of a "canvas" with a new version so anything holding an older version knows the row's contents changed
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @param r : int representing the index in pixels (top row being zero) of the row that changed
+ * @return nothing
+ * @modifies currentCanvas
+ */
+void mark_row_changed(canvas* currentCanvas, int r) {
+    currentCanvas->version = next_version();
+    currentCanvas->row_versions[r] = currentCanvas->version;
+}
+
+/**
+ * Checks if two rows hold the same pixels, a NULL row being all background
+ * @param firstRow : string representing the first row, or NULL
+ * @param secondRow : string representing the second row, or NULL
+ * @param numCols : int representing the number of columns in both rows
+ * @return true if every pixel matches
+ */
+bool rows_match(char* firstRow, char* secondRow, int numCols) {
+    if (firstRow == secondRow) return true;
+    for (int c = 0; c < numCols; c++) {
+        char first = (firstRow == NULL) ? BACKGROUND : firstRow[c];
+        char second = (secondRow == NULL) ? BACKGROUND : secondRow[c];
+        if (first != second) return false;
+    }
+    return true;
+}
+
+/**
+ * Changes how many rows the row arrays (pixels, row_versions and row_shared) of a "canvas" have room for, without changing num_rows
+ * Shrinking always succeeds: if memory cannot be given back the arrays keep their old size, which still holds every row
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @param numRows : int representing the number of rows to make room for
+ * @return true if there is room for numRows rows, false if there was not enough memory to grow the arrays (leaving the rows as they were)
+ * @modifies currentCanvas
+ */
+bool resize_row_arrays(canvas* currentCanvas, int numRows) {
+    if (numRows == 0) {
+        free(currentCanvas->pixels);
+        free(currentCanvas->row_shared);
+        free(currentCanvas->row_versions);
+        currentCanvas->pixels = NULL;
+        currentCanvas->row_shared = NULL;
+        currentCanvas->row_versions = NULL;
+        return true;
+    }
+    char** pixels = (char**)realloc(currentCanvas->pixels, numRows * sizeof(char*));
+    if (pixels != NULL) currentCanvas->pixels = pixels;
+    bool* row_shared = (bool*)realloc(currentCanvas->row_shared, numRows * sizeof(bool));
+    if (row_shared != NULL) currentCanvas->row_shared = row_shared;
+    unsigned long* row_versions = (unsigned long*)realloc(currentCanvas->row_versions, numRows * sizeof(unsigned long));
+    if (row_versions != NULL) currentCanvas->row_versions = row_versions;
+    return (pixels != NULL && row_shared != NULL && row_versions != NULL) || numRows <= currentCanvas->num_rows;
+}
+
 /**
  * Creates a new point struct with specified x and y coordinates for x and y members
  * @param x : int representing x value for point
@@ -41,19 +190,201 @@ point create_point(int x, int y) {
     return pointStruct;
 }   
 
+/**
+ * Gets a row of a "canvas" to draw on, allocating it (filled with BACKGROUND) if nothing has been drawn on it yet
+ * or copying it if it is shared with a saved canvas
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @param r : int representing the index in pixels (top row being zero) of the row
+ * @return the row's pixels, or NULL (leaving the row as it was) if there was not enough memory for them
+ * @modifies currentCanvas
+ */
+char* get_writable_row(canvas* currentCanvas, int r) {
+    if (currentCanvas->pixels[r] == NULL) {
+        char* row = (char*)calloc(currentCanvas->num_cols, sizeof(char));
+        if (row == NULL) return NULL;
+        currentCanvas->pixels[r] = row;
+    }
+    else if (currentCanvas->row_shared[r]) {
+        char* row = (char*)malloc(currentCanvas->num_cols * sizeof(char));
+        if (row == NULL) return NULL;
+        memcpy(row, currentCanvas->pixels[r], currentCanvas->num_cols);
+        currentCanvas->pixels[r] = row;
+    }
+    currentCanvas->row_shared[r] = false;
+    return currentCanvas->pixels[r];
+}
+
+/**
+ * Switches between displaying the whole canvas after each command and the machine-readable output of only the rows that changed
+ * @param enabled : true to display only changed rows, false to display the whole canvas
+ * @return nothing
+ * @modifies which output print_canvas gives
+ */
+void set_diff_output(bool enabled) {
+    diff_output = enabled;
+}
+
+/**
+ * Checks which output has been selected with set_diff_output
+ * @param none : none
+ * @return true if only changed rows are displayed
+ */
+bool is_diff_output() {
+    return diff_output;
+}
+
+/**
+ * Displays rows of a "canvas" in machine-readable form: a "@ num_rows num_cols num_rows_shown" line,
+ * then one "row pixels" line per row shown (row numbered from the bottom, pixels without spaces)
+ * @param currentCanvas : canvas struct representing canvas to print
+ * @param only_changed : true to show only rows changed since rows were last shown, false to show every row
+ * @return nothing
+ * @modifies nothing
+ */
+void print_canvas_rows(canvas currentCanvas, bool only_changed) {
+    // no row is newer than the canvas itself, so an unchanged canvas needs no scan of its rows
+    bool any_changed = !only_changed || currentCanvas.version > printed_version;
+    int num_shown = 0;
+    for (int r = 0; any_changed && r < currentCanvas.num_rows; r++) {
+        if (!only_changed || currentCanvas.row_versions[r] > printed_version) num_shown++;
+    }
+    printf("@ %d %d %d\n", currentCanvas.num_rows, currentCanvas.num_cols, num_shown);
+    for (int r = 0; any_changed && r < currentCanvas.num_rows; r++) {
+        if (only_changed && currentCanvas.row_versions[r] <= printed_version) continue;
+        printf("%d ", currentCanvas.num_rows - r - 1);
+        for (int c = 0; c < currentCanvas.num_cols; c++) {
+            if (currentCanvas.pixels[r] == NULL || currentCanvas.pixels[r][c] == BACKGROUND) putchar('*');
+            else putchar(currentCanvas.pixels[r][c]);
+        }
+        printf("\n");
+    }
+    printed_version = version_clock;
+}
+
+/**
+ * Displays every row of a "canvas", in whichever output has been selected with set_diff_output
+ * @param currentCanvas : canvas struct representing canvas to print
+ * @return nothing
+ * @modifies nothing
+ */
+void print_full_canvas(canvas currentCanvas) {
+    if (diff_output) print_canvas_rows(currentCanvas, false);
+    else print_canvas(currentCanvas);
+}
+
+/**
+ * Counts the bytes a "canvas" would use after being resized, counting rows shared with a saved canvas only if resizing copies them
+ * The segment index is counted as it is now, with its buckets for the new size
+ * @param currentCanvas : pointer to canvas struct representing the canvas to count
+ * @param numRows : int representing the number of rows after resizing (rows are removed from the top)
+ * @param numCols : int representing the number of columns after resizing
+ * @return the number of bytes
+ */
+size_t resized_footprint(canvas* currentCanvas, int numRows, int numCols) {
+    size_t bytes = sizeof(canvas) + (size_t)numRows * ROW_OVERHEAD + segment_index_footprint(&currentCanvas->segments, numRows, numCols);
+    if (currentCanvas->name != NULL) bytes += strlen(currentCanvas->name) + 1;
+    int removedRows = (currentCanvas->num_rows > numRows) ? currentCanvas->num_rows - numRows : 0;
+    for (int r = removedRows; r < currentCanvas->num_rows; r++) {
+        if (currentCanvas->pixels[r] == NULL) continue;
+        if (numCols != currentCanvas->num_cols || !currentCanvas->row_shared[r]) bytes += numCols;
+    }
+    return bytes;
+}
+
+/**
+ * Counts the bytes a "canvas" uses, counting rows shared with another canvas only for the canvas that frees them
+ * @param currentCanvas : pointer to canvas struct representing the canvas to count
+ * @return the number of bytes
+ */
+size_t canvas_footprint(canvas* currentCanvas) {
+    return resized_footprint(currentCanvas, currentCanvas->num_rows, currentCanvas->num_cols);
+}
+
+/**
+ * Counts the bytes get_writable_row would allocate for a row of a "canvas"
+ * @param currentCanvas : pointer to canvas struct representing the canvas to count
+ * @param r : int representing the index in pixels (top row being zero) of the row
+ * @return the number of bytes
+ */
+size_t writable_row_footprint(canvas* currentCanvas, int r) {
+    if (currentCanvas->pixels[r] == NULL || currentCanvas->row_shared[r]) return currentCanvas->num_cols;
+    return 0;
+}
+
+/**
+ * Checks whether the current canvas could use a number of bytes, along with the saved canvases, without going over the memory limit
+ * @param canvasBytes : size_t representing the bytes the current canvas would use
+ * @return true if there is no memory limit or the total is within it
+ */
+bool fits_memory_limit(size_t canvasBytes) {
+    return memory_limit == 0 || saved_footprint + canvasBytes <= memory_limit;
+}
+
+/**
+ * Checks whether a memory limit has been set
+ * @param none : none
+ * @return true if commands are checked against a memory limit
+ */
+bool has_memory_limit() {
+    return memory_limit != 0;
+}
+
+/**
+ * Sets the most memory the current and saved canvases may use together, commands that would use more fail
+ * @param limitBytes : size_t representing the limit in bytes, or 0 for no limit
+ * @return nothing
+ * @modifies the memory limit
+ */
+void set_memory_limit(size_t limitBytes) {
+    memory_limit = limitBytes;
+}
+
+/**
+ * Records the memory the current and saved canvases use together if it is the most they have used so far
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @return nothing
+ * @modifies the peak memory footprint
+ */
+void update_peak_footprint(canvas* currentCanvas) {
+    size_t total = saved_footprint + canvas_footprint(currentCanvas);
+    if (total > peak_footprint) peak_footprint = total;
+}
+
+/**
+ * Prints the memory (in KB, rounded up) used by the current canvas, the saved canvases, both together and at most so far, and the limit
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @return nothing
+ * @modifies the peak memory footprint
+ */
+void print_memory_usage(canvas* currentCanvas) {
+    size_t current = canvas_footprint(currentCanvas);
+    update_peak_footprint(currentCanvas);
+    printf("Current canvas: %zu KB\n", (current + 1023) / 1024);
+    printf("Saved canvases: %zu KB\n", (saved_footprint + 1023) / 1024);
+    printf("Total: %zu KB (peak %zu KB)\n", (current + saved_footprint + 1023) / 1024, (peak_footprint + 1023) / 1024);
+    if (memory_limit == 0) printf("Limit: none\n");
+    else printf("Limit: %zu KB\n", memory_limit / 1024);
+}
+
 /** 
  * Displays a "canvas" by printing all elements in the the struct's member pixels, a 2d array, along with x and y axis labels
+ * (or only the rows that changed, if set_diff_output has been turned on)
  * @param currentCanvas : canvas struct representing canvas to print
  * @return nothing
  * @modifies nothing
  */
 void print_canvas(canvas currentCanvas) {
+    if (diff_output) {
+        print_canvas_rows(currentCanvas, true);
+        return;
+    }
     int y_axis_label = currentCanvas.num_rows - 1;
     for (int r = 0; r < currentCanvas.num_rows; r++) {
         printf("%d ", y_axis_label);
         y_axis_label--;
         for (int c = 0; c < currentCanvas.num_cols; c++) {
-            printf("%c ", currentCanvas.pixels[r][c]);
+            if (currentCanvas.pixels[r] == NULL || currentCanvas.pixels[r][c] == BACKGROUND) printf("* ");
+            else printf("%c ", currentCanvas.pixels[r][c]);
         }
         printf("\n");
     }
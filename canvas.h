@@ -2,21 +2,54 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <math.h>
+#include "segments.h"
 #ifndef CANVAS_H
 #define CANVAS_H
 
+// pixels holding BACKGROUND have nothing drawn on them and are displayed as '*';
+// a row of pixels that is NULL has nothing drawn on it and is only allocated when first drawn on;
+// a row marked in row_shared belongs to a saved canvas and is copied before it is changed
+#define BACKGROUND '\0'
+
+// bytes a canvas uses for each row besides the row's pixels
+#define ROW_OVERHEAD (sizeof(char*) + sizeof(unsigned long) + sizeof(bool))
+
+typedef struct point_struct{
+    int x;
+    int y;
+} point;
+point create_point(int x, int y);   
 typedef struct canvas_struct{
     int num_rows;
     int num_cols;
     char** pixels;
     char* name;
+    unsigned long version;
+    unsigned long* row_versions;
+    bool* row_shared;
+    segment_index segments;
 } canvas;
 canvas create_canvas(int num_rows, int num_cols);
+canvas share_canvas(canvas* sourceCanvas);
+canvas snapshot_canvas(canvas* currentCanvas, char* name);
+void free_canvas(canvas* currentCanvas);
 void print_canvas(canvas currentCanvas);
-typedef struct point_struct{
-    int x;
-    int y;
-} point;
-point create_point(int x, int y);   
+void set_diff_output(bool enabled);
+bool is_diff_output();
+void print_canvas_rows(canvas currentCanvas, bool only_changed);
+void print_full_canvas(canvas currentCanvas);
+unsigned long next_version();
+void mark_row_changed(canvas* currentCanvas, int r);
+bool rows_match(char* firstRow, char* secondRow, int numCols);
+char* get_writable_row(canvas* currentCanvas, int r);
+bool resize_row_arrays(canvas* currentCanvas, int numRows);
+size_t resized_footprint(canvas* currentCanvas, int numRows, int numCols);
+size_t canvas_footprint(canvas* currentCanvas);
+size_t writable_row_footprint(canvas* currentCanvas, int r);
+bool fits_memory_limit(size_t canvasBytes);
+bool has_memory_limit();
+void set_memory_limit(size_t limitBytes);
+void update_peak_footprint(canvas* currentCanvas);
+void print_memory_usage(canvas* currentCanvas);
 
 #endif
\ No newline at end of file
@@ -12,29 +12,16 @@
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @param savedCanvases : array of canvas structs representing saved canvases
  * @param num_saved_canvases : int representing the number of canvases saved
- * @param canvasLoaded : int representing index in SavedCanvases of the canvas loaded (to avoid double free)
  * @return nothing
  * @modifies frees memory from currentCanvas and savedCanvases
  */
-void quit(canvas* currentCanvas, canvas* savedCanvases, int num_saved_canvases, int canvasLoaded) {
-    if (num_saved_canvases == 0) {
-        for (int r = 0; r < currentCanvas->num_rows; r++) {
-            free(currentCanvas->pixels[r]);
-        }
-        free(currentCanvas->pixels);
-    } else {
-        for (int i = 0; i < num_saved_canvases; i++) {
-            if (i != canvasLoaded) {
-                for (int r = 0; r < savedCanvases[i].num_rows; r++) {
-                    free(savedCanvases[i].pixels[r]);
-                }
-                free(savedCanvases[i].pixels);
-                free(savedCanvases[i].name);
-            }
-        }
-        free(savedCanvases);   
-        savedCanvases = NULL;
+void quit(canvas* currentCanvas, canvas* savedCanvases, int num_saved_canvases) {
+    free_canvas(currentCanvas);
+    for (int i = 0; i < num_saved_canvases; i++) {
+        free_canvas(&savedCanvases[i]);
     }
+    free(savedCanvases);   
+    free_batch();
     exit(0);
 }
 
@@ -53,80 +40,146 @@ void print_help() {
   printf("Add row or column: a [r | c] pos\n");
   printf("Delete row or column: d [r | c] pos\n");
   printf("Erase: e row col\n");
+  printf("Erase line: x row col\n");
+  printf("Find lines: f row col row col\n");
   printf("Save: s file_name\n");
   printf("Load: l file_name\n");
+  printf("Print: p\n");
+  printf("Output mode: o [f | d]\n");
+  printf("Memory: m [limit_kb]\n");
+  printf("Batch: b window_size\n");
 }
 
 /**
- * Draws a horizontal line specified by two points on a "canvas"
- * @param firstPoint : point struct representing the "first point"
- * @param secondPoint : point struct representing the "second point" 
- * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * Prints why a command failed when it would have taken the canvases over the memory limit or memory ran out
+ * @param improperMessage : string representing the command's improper command message
+ * @param overLimit : true if the command would have gone over the memory limit, false if memory could not be allocated
  * @return nothing
- * @modifies currentCanvas
+ * @modifies nothing
  */
-void draw_horizontal_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
-    for (int c = firstPoint.x; c <= secondPoint.x; c++) {
-        if (currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] == '*') currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] = '-';
-        else if (currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] != '-') currentCanvas->pixels[currentCanvas->num_rows - firstPoint.y - 1][c] = '+';
-        }
-    print_canvas(*currentCanvas); 
+void print_memory_error(char* improperMessage, bool overLimit) {
+    printf("%s\n", improperMessage);
+    if (overLimit) printf("The canvas would use more memory than the limit.\n");
+    else printf("There is not enough memory for the canvas.\n");
 }
 
 /**
- * Draws a vertical line specified by two points on a "canvas"
- * @param firstPoint : point struct representing the "first point"
- * @param secondPoint : point struct representing the "second point" 
+ * Prints the memory the canvases use, first setting the memory limit in KB (0 for none) if one is taken from the user (if valid), otherwise prints what's wrong
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @return nothing
- * @modifies currentCanvas
+ * @modifies the memory limit
  */
-void draw_vertical_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
-    for (int r = firstPoint.y; r <= secondPoint.y; r++) {
-        if (currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] == '*') currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] = '|';
-        else if (currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] != '|') currentCanvas->pixels[currentCanvas->num_rows - r - 1][firstPoint.x] = '+';
+void memory(canvas* currentCanvas) {
+    int c;
+    while ((c = getc(command_input())) == ' ' || c == '\t');
+    if (c != '\n' && c != EOF) {
+        ungetc(c, command_input());
+        int limit = getPosInt(true);
+        if (limit < 0) {
+            printf("Improper memory command.\n");
+            print_canvas(*currentCanvas);
+            if (limit == -2) while ((c = getc(command_input())) != '\n' && c != EOF);
+            return;
         }
-    print_canvas(*currentCanvas); 
+        set_memory_limit((size_t)limit * 1024);
+    }
+    print_memory_usage(currentCanvas);
+    print_canvas(*currentCanvas);
 }
 
 /**
- * Draws a left diagonal line specified by two points on a "canvas"
- * @param firstPoint : point struct representing the "first point"
- * @param secondPoint : point struct representing the "second point" 
+ * Sets how many lines of input are read ahead and coalesced before being run depending on input taken from the user (if valid, 0 to run each command as it is entered), otherwise prints what's wrong
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @return nothing
- * @modifies currentCanvas
+ * @modifies the batch window
  */
-void draw_left_diagonal_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
-    int i = firstPoint.y;
-    for (int c = firstPoint.x; c <= secondPoint.x; c++) {
-        if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] == '*') currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '/';
-        else if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] != '/') currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '+';
-        i++;
-    }
-    print_canvas(*currentCanvas); 
+void batch(canvas* currentCanvas) {
+    int c;
+    int window = getPosInt(true);
+    if (window >= 0 && window <= MAX_BATCH_WINDOW) {
+        set_batch_window(window);
+    }
+    else {
+        printf("Improper batch command.\n");
+        if (window == -2) while ((c = getc(command_input())) != '\n' && c != EOF);
+    }
+    print_canvas(*currentCanvas);
 }
 
 /**
- * Draws a right diagonal line specified by two points on a "canvas"
- * @param firstPoint : point struct representing the "first point"
- * @param secondPoint : point struct representing the "second point" 
+ * Sets the output mode depending on input taken from the user (if valid) and prints the whole canvas in that mode, otherwise prints what's wrong
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @return nothing
- * @modifies currentCanvas
+ * @modifies which output print_canvas gives
+ */
+void output(canvas* currentCanvas) {
+    char selection;
+    int c;
+    int numArgsRead = fscanf(command_input(), " %c", &selection);
+    bool isLastOnLine = isValidFormat(1, numArgsRead, true);
+    if (isLastOnLine && (selection == 'f' || selection == 'd')) {
+        // ends the line of the prompt entered before switching, after that no prompt is printed
+        if (selection == 'd' && !is_diff_output()) printf("\n");
+        set_diff_output(selection == 'd');
+        print_full_canvas(*currentCanvas);
+    }
+    else {
+        printf("Improper output command.\n");
+        print_canvas(*currentCanvas);
+        if (!isLastOnLine) while ((c = getc(command_input())) != '\n' && c != EOF);
+    }
+}
+
+/**
+ * Defines a function that draws a line specified by two points on a "canvas", one cell at a time from firstPoint towards secondPoint, then prints the canvas
+ * The step and glyph are compile-time constants, so each function gets its own loop with no per-cell checks of the line type
+ * The cells are drawn by name##_cells, which is also defined and does not print (so it can be timed on its own, see bench.c)
+ * Both functions return false, leaving the canvas as it was, if there is not enough memory for the rows the line crosses
+ * @param name : name of the function to define
+ * @param dx : column step between cells (0 or 1)
+ * @param dy : row step between cells (-1, 0 or 1, up being positive)
+ * @param glyph : char drawn on empty cells, cells holding another glyph become '+'
+ * Only rows with a pixel that actually changed are marked, so drawing over the same glyph leaves the diff output empty
  */
-void draw_right_diagonal_line(point firstPoint, point secondPoint, canvas* currentCanvas) {
-    int i = firstPoint.y;
-    for (int c = firstPoint.x; c <= secondPoint.x; c++) {
-        if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] == '*') currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '\\';
-        else if (currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] != '\\') currentCanvas->pixels[currentCanvas->num_rows - i - 1][c] = '+';
-        i--;
-    }
-    print_canvas(*currentCanvas); 
+#define DEFINE_DRAW_LINE(name, dx, dy, glyph) \
+bool name##_cells(point firstPoint, point secondPoint, canvas* currentCanvas) { \
+    int length = ((dx) != 0) ? secondPoint.x - firstPoint.x + 1 : secondPoint.y - firstPoint.y + 1; \
+    int r = currentCanvas->num_rows - firstPoint.y - 1; \
+    for (int i = 0; i < (((dy) != 0) ? length : 1); i++) { \
+        if (get_writable_row(currentCanvas, r - i * (dy)) == NULL) return false; \
+    } \
+    char* row = currentCanvas->pixels[r]; \
+    bool changed = false; \
+    for (int i = 0; i < length; i++) { \
+        if ((dy) != 0) row = currentCanvas->pixels[r - i * (dy)]; \
+        char* pixel = &row[firstPoint.x + i * (dx)]; \
+        char old = *pixel; \
+        if (*pixel == BACKGROUND) *pixel = (glyph); \
+        else if (*pixel != (glyph)) *pixel = '+'; \
+        if ((dy) != 0 && *pixel != old) mark_row_changed(currentCanvas, r - i * (dy)); \
+        else if (*pixel != old) changed = true; \
+    } \
+    if ((dy) == 0 && changed) mark_row_changed(currentCanvas, r); \
+    return true; \
+} \
+bool name(point firstPoint, point secondPoint, canvas* currentCanvas) { \
+    if (!name##_cells(firstPoint, secondPoint, currentCanvas)) return false; \
+    print_canvas(*currentCanvas); \
+    return true; \
 }
 
+// horizontal line, firstPoint left of secondPoint
+DEFINE_DRAW_LINE(draw_horizontal_line, 1, 0, '-')
+// vertical line, firstPoint below secondPoint
+DEFINE_DRAW_LINE(draw_vertical_line, 0, 1, '|')
+// left diagonal line (slope of 1), firstPoint below and left of secondPoint
+DEFINE_DRAW_LINE(draw_left_diagonal_line, 1, 1, '/')
+// right diagonal line (slope of -1), firstPoint above and left of secondPoint
+DEFINE_DRAW_LINE(draw_right_diagonal_line, 1, -1, '\\')
+
 /**
  * Writes or "draws" a line on a "canvas", checking what kind of line two points taken from the user represent (if any) first, otherwise prints whats wrong
+ * The line is also added to the canvas's segment index
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @return nothing
  * @modifies currentCanvas
@@ -140,37 +193,65 @@ void write(canvas* currentCanvas) {
     if (y2 < 0) {
         printf("Improper draw command.\n");
         print_canvas(*currentCanvas); 
-        while ((c = getchar()) != '\n' && c != EOF);
+        while ((c = getc(command_input())) != '\n' && c != EOF);
     } 
+    else if (x1 < 0 || y1 < 0 || x2 < 0) {
+        // a negative point would pass the bounds check below, the line was already read up to y2
+        printf("Improper draw command.\n");
+        print_canvas(*currentCanvas); 
+    }
     else {
         point firstPoint = create_point(y1, x1);
         point secondPoint = create_point(y2, x2);
         char lineType = type_of_line(firstPoint, secondPoint, currentCanvas);
-        if (lineType == 'H') {
-            if (firstPoint.x <= secondPoint.x) draw_horizontal_line(firstPoint, secondPoint, currentCanvas);
-            else draw_horizontal_line(secondPoint, firstPoint, currentCanvas);
+        segment line = create_line_segment(firstPoint.x, firstPoint.y, secondPoint.x, secondPoint.y);
+        if (lineType != '!') {
+            // the line copies every blank or shared row it crosses
+            size_t lineBytes = canvas_footprint(currentCanvas) + add_segment_footprint(&currentCanvas->segments, line);
+            int yLow = (firstPoint.y < secondPoint.y) ? firstPoint.y : secondPoint.y;
+            int yHigh = (firstPoint.y < secondPoint.y) ? secondPoint.y : firstPoint.y;
+            for (int y = yLow; y <= yHigh; y++) {
+                lineBytes += writable_row_footprint(currentCanvas, currentCanvas->num_rows - y - 1);
+            }
+            if (!fits_memory_limit(lineBytes)) {
+                print_memory_error("Improper draw command.", true);
+                print_canvas(*currentCanvas);
+                return;
+            }
+        }
+        bool drawn = true;
+        // room for the line in the segment index is made first, so running out of memory leaves the canvas as it was
+        if (lineType != '!' && !make_room_for_segment(&currentCanvas->segments, line)) drawn = false;
+        else if (lineType == 'H') {
+            if (firstPoint.x <= secondPoint.x) drawn = draw_horizontal_line(firstPoint, secondPoint, currentCanvas);
+            else drawn = draw_horizontal_line(secondPoint, firstPoint, currentCanvas);
         }
         else if (lineType == 'V') {
-            if (firstPoint.y <= secondPoint.y) draw_vertical_line(firstPoint, secondPoint, currentCanvas);
-            else draw_vertical_line(secondPoint, firstPoint, currentCanvas);
+            if (firstPoint.y <= secondPoint.y) drawn = draw_vertical_line(firstPoint, secondPoint, currentCanvas);
+            else drawn = draw_vertical_line(secondPoint, firstPoint, currentCanvas);
         }
         else if (lineType == 'L') {
-            if (firstPoint.y <= secondPoint.y) draw_left_diagonal_line(firstPoint, secondPoint, currentCanvas);
-            else draw_left_diagonal_line(secondPoint, firstPoint, currentCanvas);
+            if (firstPoint.y <= secondPoint.y) drawn = draw_left_diagonal_line(firstPoint, secondPoint, currentCanvas);
+            else drawn = draw_left_diagonal_line(secondPoint, firstPoint, currentCanvas);
         }
         else if (lineType == 'R') {
-            if (firstPoint.y >= secondPoint.y) draw_right_diagonal_line(firstPoint, secondPoint, currentCanvas);
-            else draw_right_diagonal_line(secondPoint, firstPoint, currentCanvas);
+            if (firstPoint.y >= secondPoint.y) drawn = draw_right_diagonal_line(firstPoint, secondPoint, currentCanvas);
+            else drawn = draw_right_diagonal_line(secondPoint, firstPoint, currentCanvas);
         }
         else if (lineType == '!') {
             printf("Improper draw command.\n");
             print_canvas(*currentCanvas); 
         } 
+        if (drawn && lineType != '!') add_segment(&currentCanvas->segments, line);
+        if (!drawn) {
+            print_memory_error("Improper draw command.", false);
+            print_canvas(*currentCanvas);
+        }
     }  
 }
 
 /**
- * Erases a "pixel" on a "canvas" by taking input from user (if valid) sets a char element on the 2d array back to '*', otherwise prints what's wrong
+ * Erases a "pixel" on a "canvas" by taking input from user (if valid) sets a char element on the 2d array back to BACKGROUND, otherwise prints what's wrong
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @return nothing
  * @modifies currentCanvas
@@ -182,71 +263,198 @@ void erase(canvas* currentCanvas) {
     if (y < 0) {
         printf("Improper erase command.\n");
         print_canvas(*currentCanvas); 
-        while ((c = getchar()) != '\n' && c != EOF);
+        while ((c = getc(command_input())) != '\n' && c != EOF);
     } 
+    else if (x < 0) {
+        printf("Improper erase command.\n");
+        print_canvas(*currentCanvas); 
+    }
     else {
         point erasePoint = create_point(y, x);
+        int r = currentCanvas->num_rows - erasePoint.y - 1;
         if (is_points_in_canvas(erasePoint, erasePoint, *currentCanvas)) {
-            currentCanvas->pixels[currentCanvas->num_rows - erasePoint.y - 1][erasePoint.x] = '*';
+            // erasing copies a row shared with a saved canvas, a blank row or cell is left as it is (and not marked as changed)
+            bool erasing = currentCanvas->pixels[r] != NULL && currentCanvas->pixels[r][erasePoint.x] != BACKGROUND;
+            segment_edit edit = create_segment_edit('e', ' ', erasePoint.x, erasePoint.y);
+            if (erasing && !fits_memory_limit(canvas_footprint(currentCanvas) + writable_row_footprint(currentCanvas, r)
+                + edit_segments_footprint(&currentCanvas->segments, edit, currentCanvas->num_rows, currentCanvas->num_cols))) {
+                print_memory_error("Improper erase command.", true);
+            }
+            else if (erasing && (get_writable_row(currentCanvas, r) == NULL
+                || !edit_segments(&currentCanvas->segments, edit, currentCanvas->num_rows, currentCanvas->num_cols))) {
+                print_memory_error("Improper erase command.", false);
+            }
+            else if (erasing) {
+                currentCanvas->pixels[r][erasePoint.x] = BACKGROUND;
+                mark_row_changed(currentCanvas, r);
+            }
             print_canvas(*currentCanvas); 
         }
     }
 }
 
 /**
- * Adds a row to a "canvas" by allocating memory for another row, shifting rows to make room, and setting the row's elements to '*'
+ * Erases every line drawn through a "pixel" on a "canvas" by taking input from user (if valid), redrawing the pixels of those lines from the lines left, otherwise prints what's wrong
+ * The lines are found through the canvas's segment index, so only the buckets around the pixel are looked at
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
- * @param rowPos : int representing which row position (bottom row being zero) to insert a new row
  * @return nothing
  * @modifies currentCanvas
  */
-void add_row(canvas* currentCanvas, int rowPos) {
-    currentCanvas->pixels = (char**)realloc(currentCanvas->pixels, (currentCanvas->num_rows + 1) * sizeof(char*));
-    currentCanvas->pixels[currentCanvas->num_rows] = (char*)malloc((currentCanvas->num_cols) * sizeof(char));
-    for (int c = 0; c < currentCanvas->num_cols; c++) {
-        currentCanvas->pixels[currentCanvas->num_rows][c] = '*';
+void erase_line(canvas* currentCanvas) {
+    int c;
+    int x = getPosInt(false);
+    int y = getPosInt(true);
+    if (y < 0) {
+        printf("Improper erase line command.\n");
+        print_canvas(*currentCanvas); 
+        while ((c = getc(command_input())) != '\n' && c != EOF);
+        return;
+    } 
+    point erasePoint = create_point(y, x);
+    if (x < 0 || !is_points_in_canvas(erasePoint, erasePoint, *currentCanvas)) {
+        printf("Improper erase line command.\n");
+        print_canvas(*currentCanvas); 
+        return;
     }
-    currentCanvas->num_rows++;
-    if (rowPos == currentCanvas->num_rows - 1) {
-        for (int r = currentCanvas->num_rows - 1; r > 0; r--) {
-            for (int c = 0; c < currentCanvas->num_cols; c++) {
-                    currentCanvas->pixels[r][c] = currentCanvas->pixels[r - 1][c];
-            }
+    segment* pieces = NULL;
+    int numPieces = find_lines(&currentCanvas->segments, erasePoint.x, erasePoint.y, &pieces);
+    bool* counted = (bool*)calloc(currentCanvas->num_rows, sizeof(bool));
+    if (numPieces < 0 || counted == NULL) {
+        print_memory_error("Improper erase line command.", false);
+        free(counted);
+        if (numPieces >= 0) free(pieces);
+        print_canvas(*currentCanvas);
+        return;
+    }
+    // every row the lines cross is copied if it is shared, each counted once
+    size_t eraseBytes = canvas_footprint(currentCanvas);
+    for (int p = 0; p < numPieces; p++) {
+        for (int i = 0; i < pieces[p].length; i++) {
+            int r = currentCanvas->num_rows - (pieces[p].y + i * pieces[p].dy) - 1;
+            if (!counted[r]) eraseBytes += writable_row_footprint(currentCanvas, r);
+            counted[r] = true;
         }
     }
+    bool overLimit = !fits_memory_limit(eraseBytes);
+    bool writable = !overLimit;
+    for (int r = 0; r < currentCanvas->num_rows && writable; r++) {
+        if (counted[r] && get_writable_row(currentCanvas, r) == NULL) writable = false;
+    }
+    if (overLimit) print_memory_error("Improper erase line command.", true);
+    else if (!writable) print_memory_error("Improper erase line command.", false);
     else {
-        for (int r = currentCanvas->num_rows - 1; r >= currentCanvas->num_rows - rowPos - 1; r--) {
-            for (int c = 0; c < currentCanvas->num_cols; c++) {
-                currentCanvas->pixels[r][c] = currentCanvas->pixels[r - 1][c];
+        remove_lines(&currentCanvas->segments, erasePoint.x, erasePoint.y);
+        // a pixel crossed by a line left keeps that line's character
+        for (int p = 0; p < numPieces; p++) {
+            for (int i = 0; i < pieces[p].length; i++) {
+                int cellX = pieces[p].x + i * pieces[p].dx;
+                int cellY = pieces[p].y + i * pieces[p].dy;
+                int r = currentCanvas->num_rows - cellY - 1;
+                char pixel = glyph_at(&currentCanvas->segments, cellX, cellY);
+                if (currentCanvas->pixels[r][cellX] != pixel) {
+                    currentCanvas->pixels[r][cellX] = pixel;
+                    mark_row_changed(currentCanvas, r);
+                }
             }
         }
     }
-    for (int c = 0; c < currentCanvas->num_cols; c++) {
-        currentCanvas->pixels[currentCanvas->num_rows - rowPos - 1][c] = '*'; 
+    free(counted);
+    free(pieces);
+    print_canvas(*currentCanvas);
+}
+
+/**
+ * Prints what is drawn of every line crossing a region of a "canvas", taking two opposite corners of the region from the user (if valid), otherwise prints what's wrong
+ * Each piece of a line is printed as the draw command that would draw it, and only the buckets of the segment index under the region are looked at
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @return nothing
+ * @modifies nothing
+ */
+void find(canvas* currentCanvas) {
+    int c;
+    int x1 = getPosInt(false);
+    int y1 = getPosInt(false);
+    int x2 = getPosInt(false);
+    int y2 = getPosInt(true);
+    if (y2 < 0) {
+        printf("Improper find command.\n");
+        print_canvas(*currentCanvas); 
+        while ((c = getc(command_input())) != '\n' && c != EOF);
+        return;
+    } 
+    point firstPoint = create_point(y1, x1);
+    point secondPoint = create_point(y2, x2);
+    if (x1 < 0 || y1 < 0 || x2 < 0 || !is_points_in_canvas(firstPoint, secondPoint, *currentCanvas)) {
+        printf("Improper find command.\n");
+        print_canvas(*currentCanvas); 
+        return;
+    }
+    segment* found = NULL;
+    int numFound = find_segments(&currentCanvas->segments, (y1 < y2) ? y1 : y2, (x1 < x2) ? x1 : x2, (y1 < y2) ? y2 : y1, (x1 < x2) ? x2 : x1, &found);
+    if (numFound < 0) print_memory_error("Improper find command.", false);
+    else {
+        printf("Lines in region: %d\n", numFound);
+        for (int f = 0; f < numFound; f++) {
+            segment line = found[f];
+            printf("w %d %d %d %d\n", line.y, line.x, line.y + (line.length - 1) * line.dy, line.x + (line.length - 1) * line.dx);
+        }
+        free(found);
+    }
+    print_canvas(*currentCanvas);
+}
+
+/**
+ * Adds a row to a "canvas" by making room for another row and shifting rows to make room, the new row is left blank (NULL) until drawn on
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @param rowPos : int representing which row position (bottom row being zero) to insert a new row
+ * @return true if the row was added, false if there was not enough memory (leaving the canvas as it was)
+ * @modifies currentCanvas
+ */
+bool add_row(canvas* currentCanvas, int rowPos) {
+    int newRow = currentCanvas->num_rows - rowPos;
+    if (!resize_row_arrays(currentCanvas, currentCanvas->num_rows + 1)) return false;
+    // a failure here leaves the grown arrays with room for a row that is not used
+    if (!edit_segments(&currentCanvas->segments, create_segment_edit('a', 'r', 0, rowPos), currentCanvas->num_rows + 1, currentCanvas->num_cols)) return false;
+    // rows are moved by pointer, so only the row pointers below the new row are shifted, not their pixels
+    memmove(currentCanvas->pixels + newRow + 1, currentCanvas->pixels + newRow, rowPos * sizeof(char*));
+    memmove(currentCanvas->row_shared + newRow + 1, currentCanvas->row_shared + newRow, rowPos * sizeof(bool));
+    memmove(currentCanvas->row_versions + newRow + 1, currentCanvas->row_versions + newRow, rowPos * sizeof(unsigned long));
+    currentCanvas->pixels[newRow] = NULL;
+    currentCanvas->row_shared[newRow] = false;
+    currentCanvas->num_rows++;
+    // the new row and every row above it now show under a different row number
+    for (int r = 0; r <= newRow; r++) {
+        mark_row_changed(currentCanvas, r);
     }
+    return true;
 }
 
 /**
- * Adds a column to a "canvas" by allocating memory for another element on every row, shifting columns to make room, and setting the columns's elements to '*'
+ * Adds a column to a "canvas" by allocating memory for another element on every row, shifting columns to make room, and setting the columns's elements to BACKGROUND
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @param colPos : int representing which column position (left-most being zero) to insert a new column
- * @return nothing
+ * @return true if the column was added, false if there was not enough memory (leaving the canvas as it was)
  * @modifies currentCanvas
  */
-void add_col(canvas* currentCanvas, int colPos) {
+bool add_col(canvas* currentCanvas, int colPos) {
+    // every row is grown before any is shifted, so running out of memory part way leaves the pixels as they were
     for (int r = 0; r < currentCanvas->num_rows; r++) {
-        currentCanvas->pixels[r] = realloc(currentCanvas->pixels[r], (currentCanvas->num_cols + 1) * sizeof(char));
-        currentCanvas->pixels[r][currentCanvas->num_cols] = '*';
+        if (currentCanvas->pixels[r] == NULL) continue;
+        if (get_writable_row(currentCanvas, r) == NULL) return false;
+        char* row = (char*)realloc(currentCanvas->pixels[r], (currentCanvas->num_cols + 1) * sizeof(char));
+        if (row == NULL) return false;
+        currentCanvas->pixels[r] = row;
     }
-    currentCanvas->num_cols++;
+    if (!edit_segments(&currentCanvas->segments, create_segment_edit('a', 'c', colPos, 0), currentCanvas->num_rows, currentCanvas->num_cols + 1)) return false;
     for (int r = 0; r < currentCanvas->num_rows; r++) {
-        for (int c = currentCanvas->num_cols - 1; c >= colPos; c--) {
-            currentCanvas->pixels[r][c] = currentCanvas->pixels[r][c - 1];
+        if (currentCanvas->pixels[r] != NULL) {
+            memmove(currentCanvas->pixels[r] + colPos + 1, currentCanvas->pixels[r] + colPos, currentCanvas->num_cols - colPos);
+            currentCanvas->pixels[r][colPos] = BACKGROUND;
         }
+        mark_row_changed(currentCanvas, r);
     }
-    for (int r = 0; r < currentCanvas->num_rows; r++) {
-        currentCanvas->pixels[r][colPos] = '*';
-    }
+    currentCanvas->num_cols++;
+    return true;
 }
 
 /**
@@ -257,11 +465,16 @@ void add_col(canvas* currentCanvas, int colPos) {
  */
 void add(canvas* currentCanvas) {
     char selection;
-    scanf(" %c", &selection);
+    fscanf(command_input(), " %c", &selection);
     if (selection == 'r') {
         int rowPos = getPosInt(false);
-        if (rowPos >= 0 && rowPos <= currentCanvas->num_rows) {
-            add_row(currentCanvas, rowPos);
+        if (rowPos >= 0 && rowPos <= currentCanvas->num_rows && !fits_memory_limit(resized_footprint(currentCanvas, currentCanvas->num_rows + 1, currentCanvas->num_cols)
+            + edit_segments_footprint(&currentCanvas->segments, create_segment_edit('a', 'r', 0, rowPos), currentCanvas->num_rows + 1, currentCanvas->num_cols))) {
+            print_memory_error("Improper add command.", true);
+            print_canvas(*currentCanvas);
+        }
+        else if (rowPos >= 0 && rowPos <= currentCanvas->num_rows) {
+            if (!add_row(currentCanvas, rowPos)) print_memory_error("Improper add command.", false);
             print_canvas(*currentCanvas);
         }
         else {
@@ -271,8 +484,13 @@ void add(canvas* currentCanvas) {
     }
     else if (selection == 'c') {
         int colPos = getPosInt(false);
-        if (colPos >= 0 && colPos <= currentCanvas->num_cols) {
-            add_col(currentCanvas, colPos);
+        if (colPos >= 0 && colPos <= currentCanvas->num_cols && !fits_memory_limit(resized_footprint(currentCanvas, currentCanvas->num_rows, currentCanvas->num_cols + 1)
+            + edit_segments_footprint(&currentCanvas->segments, create_segment_edit('a', 'c', colPos, 0), currentCanvas->num_rows, currentCanvas->num_cols + 1))) {
+            print_memory_error("Improper add command.", true);
+            print_canvas(*currentCanvas);
+        }
+        else if (colPos >= 0 && colPos <= currentCanvas->num_cols) {
+            if (!add_col(currentCanvas, colPos)) print_memory_error("Improper add command.", false);
             print_canvas(*currentCanvas);
         }
         else {
@@ -290,33 +508,51 @@ void add(canvas* currentCanvas) {
  * Deletes a row from a "canvas" by moving rows to fill in gap and deallocating memory 
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @param rowPos : int representing which row (bottom row being zero) to delete
- * @return nothing
+ * @return true if the row was deleted, false if there was not enough memory (leaving the canvas as it was)
  * @modifies currentCanvas
  */
-void delete_row(canvas* currentCanvas, int rowPos) {
-    free(currentCanvas->pixels[currentCanvas->num_rows - rowPos - 1]);
-    for (int r = currentCanvas->num_rows - rowPos - 1; r < currentCanvas->num_rows - 1; r++) {
-        currentCanvas->pixels[r] = currentCanvas->pixels[r + 1];
-    }
-    currentCanvas->pixels = (char**)realloc(currentCanvas->pixels, (currentCanvas->num_rows - 1) * sizeof(char*));
+bool delete_row(canvas* currentCanvas, int rowPos) {
+    if (!edit_segments(&currentCanvas->segments, create_segment_edit('d', 'r', 0, rowPos), currentCanvas->num_rows - 1, currentCanvas->num_cols)) return false;
+    if (!currentCanvas->row_shared[currentCanvas->num_rows - rowPos - 1]) free(currentCanvas->pixels[currentCanvas->num_rows - rowPos - 1]);
+    memmove(currentCanvas->pixels + currentCanvas->num_rows - rowPos - 1, currentCanvas->pixels + currentCanvas->num_rows - rowPos, rowPos * sizeof(char*));
+    memmove(currentCanvas->row_shared + currentCanvas->num_rows - rowPos - 1, currentCanvas->row_shared + currentCanvas->num_rows - rowPos, rowPos * sizeof(bool));
+    memmove(currentCanvas->row_versions + currentCanvas->num_rows - rowPos - 1, currentCanvas->row_versions + currentCanvas->num_rows - rowPos, rowPos * sizeof(unsigned long));
+    resize_row_arrays(currentCanvas, currentCanvas->num_rows - 1);
     currentCanvas->num_rows--;
+    // every row above the deleted one now shows under a different row number
+    for (int r = 0; r < currentCanvas->num_rows - rowPos; r++) {
+        mark_row_changed(currentCanvas, r);
+    }
+    return true;
 }
 
 /**
  * Deletes a column from a "canvas" by moving columns to fill in gap and deallocating memory (one element per row) 
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @param colPos : int representing which column (bottom row being zero) to delete
- * @return nothing
+ * @return true if the column was deleted, false if there was not enough memory to copy the rows shared with a saved canvas (leaving the canvas as it was)
  * @modifies currentCanvas
  */
-void delete_col(canvas* currentCanvas, int colPos) {
+bool delete_col(canvas* currentCanvas, int colPos) {
     for (int r = 0; r < currentCanvas->num_rows; r++) {
-        for (int c = colPos; c < currentCanvas->num_cols; c++) {
-            currentCanvas->pixels[r][c] = currentCanvas->pixels[r][c + 1]; 
+        if (currentCanvas->pixels[r] != NULL && get_writable_row(currentCanvas, r) == NULL) return false;
+    }
+    if (!edit_segments(&currentCanvas->segments, create_segment_edit('d', 'c', colPos, 0), currentCanvas->num_rows, currentCanvas->num_cols - 1)) return false;
+    for (int r = 0; r < currentCanvas->num_rows; r++) {
+        if (currentCanvas->pixels[r] != NULL && currentCanvas->num_cols == 1) {
+            free(currentCanvas->pixels[r]);
+            currentCanvas->pixels[r] = NULL;
         }
-    currentCanvas->pixels[r] = realloc(currentCanvas->pixels[r], (currentCanvas->num_cols - 1) * sizeof(char));
+        else if (currentCanvas->pixels[r] != NULL) {
+            memmove(currentCanvas->pixels[r] + colPos, currentCanvas->pixels[r] + colPos + 1, currentCanvas->num_cols - colPos - 1);
+            // a row that cannot be shrunk keeps its old memory, which still holds every pixel
+            char* row = (char*)realloc(currentCanvas->pixels[r], (currentCanvas->num_cols - 1) * sizeof(char));
+            if (row != NULL) currentCanvas->pixels[r] = row;
+        }
+        mark_row_changed(currentCanvas, r);
     }
     currentCanvas->num_cols--;
+    return true;
 }
 
 /**
@@ -328,29 +564,40 @@ void delete_col(canvas* currentCanvas, int colPos) {
 void delete(canvas* currentCanvas) {
     char selection;
     int c;
-    scanf(" %c", &selection);
+    fscanf(command_input(), " %c", &selection);
     if (selection == 'r') {
         int rowPos = getPosInt(true); // -2 for not int -1 for not positive num
-        if (rowPos >= 0 && rowPos < currentCanvas->num_rows) {
-            delete_row(currentCanvas, rowPos);
+        if (rowPos >= 0 && rowPos < currentCanvas->num_rows && !fits_memory_limit(canvas_footprint(currentCanvas)
+            + edit_segments_footprint(&currentCanvas->segments, create_segment_edit('d', 'r', 0, rowPos), currentCanvas->num_rows - 1, currentCanvas->num_cols))) {
+            print_memory_error("Improper delete command.", true);
+            print_canvas(*currentCanvas);
+        }
+        else if (rowPos >= 0 && rowPos < currentCanvas->num_rows) {
+            if (!delete_row(currentCanvas, rowPos)) print_memory_error("Improper delete command.", false);
             print_canvas(*currentCanvas);
         }
         else {
             printf("Improper delete command.\n");
             print_canvas(*currentCanvas); 
-            while ((c = getchar()) != '\n' && c != EOF);
+            while ((c = getc(command_input())) != '\n' && c != EOF);
         }
     }
     else if (selection == 'c') {
         int colPos = getPosInt(true);
-        if (colPos >= 0 && colPos < currentCanvas->num_cols) {
-            delete_col(currentCanvas, colPos);
+        // deleting a column copies the rows shared with a saved canvas
+        if (colPos >= 0 && colPos < currentCanvas->num_cols && !fits_memory_limit(resized_footprint(currentCanvas, currentCanvas->num_rows, currentCanvas->num_cols - 1)
+            + edit_segments_footprint(&currentCanvas->segments, create_segment_edit('d', 'c', colPos, 0), currentCanvas->num_rows, currentCanvas->num_cols - 1))) {
+            print_memory_error("Improper delete command.", true);
+            print_canvas(*currentCanvas);
+        }
+        else if (colPos >= 0 && colPos < currentCanvas->num_cols) {
+            if (!delete_col(currentCanvas, colPos)) print_memory_error("Improper delete command.", false);
             print_canvas(*currentCanvas);
         }
         else {
             printf("Improper delete command.\n");
             print_canvas(*currentCanvas); 
-            while ((c = getchar()) != '\n' && c != EOF);
+            while ((c = getc(command_input())) != '\n' && c != EOF);
         }
     }
     else {
@@ -359,6 +606,64 @@ void delete(canvas* currentCanvas) {
     }
 }
 
+/**
+ * Resizes a "canvas" to the given dimensions in one pass, with the same result as adding or deleting rows at the top and columns at the right one at a time
+ * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
+ * @param numRows : int representing the number of rows the canvas should have (at least 1)
+ * @param numCols : int representing the number of columns the canvas should have (at least 1)
+ * @return true if the canvas was resized, false if there was not enough memory (leaving the canvas as it was)
+ * @modifies currentCanvas
+ */
+bool resize_canvas(canvas* currentCanvas, int numRows, int numCols) {
+    int numRowsAdd = numRows - currentCanvas->num_rows;
+    int numRowsRemoved = (numRowsAdd < 0) ? numRowsAdd * -1 : 0;
+    // everything that allocates is done before any row is moved or freed, so running out of memory leaves the canvas as it was
+    if (numRowsAdd > 0 && !resize_row_arrays(currentCanvas, numRows)) return false;
+    for (int r = numRowsRemoved; r < currentCanvas->num_rows && numCols != currentCanvas->num_cols; r++) {
+        if (currentCanvas->pixels[r] == NULL) continue;
+        if (get_writable_row(currentCanvas, r) == NULL) return false;
+        if (numCols > currentCanvas->num_cols) {
+            char* row = (char*)realloc(currentCanvas->pixels[r], numCols * sizeof(char));
+            if (row == NULL) return false;
+            currentCanvas->pixels[r] = row;
+        }
+    }
+    // rows are added and removed at the top and columns at the right, so segments are only ever cut short
+    if (!edit_segments(&currentCanvas->segments, create_segment_edit('r', ' ', numCols, numRows), numRows, numCols)) return false;
+    if (numRowsAdd < 0) {
+        for (int r = 0; r < numRowsRemoved; r++) {
+            if (!currentCanvas->row_shared[r]) free(currentCanvas->pixels[r]);
+        }
+        memmove(currentCanvas->pixels, currentCanvas->pixels + numRowsRemoved, numRows * sizeof(char*));
+        memmove(currentCanvas->row_shared, currentCanvas->row_shared + numRowsRemoved, numRows * sizeof(bool));
+        memmove(currentCanvas->row_versions, currentCanvas->row_versions + numRowsRemoved, numRows * sizeof(unsigned long));
+        resize_row_arrays(currentCanvas, numRows);
+    }
+    if (numRowsAdd > 0) {
+        memmove(currentCanvas->pixels + numRowsAdd, currentCanvas->pixels, currentCanvas->num_rows * sizeof(char*));
+        memmove(currentCanvas->row_shared + numRowsAdd, currentCanvas->row_shared, currentCanvas->num_rows * sizeof(bool));
+        memmove(currentCanvas->row_versions + numRowsAdd, currentCanvas->row_versions, currentCanvas->num_rows * sizeof(unsigned long));
+        for (int r = 0; r < numRowsAdd; r++) {
+            currentCanvas->pixels[r] = NULL;
+            currentCanvas->row_shared[r] = false;
+        }
+    }
+    currentCanvas->num_rows = numRows;
+    for (int r = 0; r < numRows; r++) {
+        if (currentCanvas->pixels[r] != NULL && numCols > currentCanvas->num_cols) {
+            memset(currentCanvas->pixels[r] + currentCanvas->num_cols, BACKGROUND, numCols - currentCanvas->num_cols);
+        }
+        else if (currentCanvas->pixels[r] != NULL && numCols < currentCanvas->num_cols) {
+            // a row that cannot be shrunk keeps its old memory, which still holds every pixel
+            char* row = (char*)realloc(currentCanvas->pixels[r], numCols * sizeof(char));
+            if (row != NULL) currentCanvas->pixels[r] = row;
+        }
+        if (numCols != currentCanvas->num_cols || r < numRowsAdd) mark_row_changed(currentCanvas, r);
+    }
+    currentCanvas->num_cols = numCols;
+    return true;
+}
+
 /**
  * Resizes a "canvas" depending on dimensions taken from user (if valid) using add and delete function calls, otherwise prints what's wrong
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
@@ -372,49 +677,32 @@ void resize(canvas* currentCanvas) {
     if (numCols == -2) {
         printf("Improper resize command.\n"); 
         print_canvas(*currentCanvas); 
-        while ((c = getchar()) != '\n' && c != EOF);
+        while ((c = getc(command_input())) != '\n' && c != EOF);
     }
     else {
-        int numRowsAdd = numRows - currentCanvas->num_rows;
-        int numColsAdd = numCols - currentCanvas->num_cols;
-        if (numRows != -2 && numRows != -1 && numCols != -2 && numCols != -1 && numRows != 0 && numCols != 0) {
-            if (numRowsAdd >= 0) {
-                for (int r = 0; r < numRowsAdd; r++) {
-                    add_row(currentCanvas, currentCanvas->num_rows);
-                }
-            }
-            if (numColsAdd >= 0) {
-                for (int c = 0; c < numColsAdd; c++) {
-                    add_col(currentCanvas, currentCanvas->num_cols);
-                }
-            }
-            if (numRowsAdd < 0) {
-                for (int r = 0; r < (numRowsAdd * -1); r++) {
-                    delete_row(currentCanvas, currentCanvas->num_rows - 1);
-                }
-            }
-            if (numColsAdd < 0) {
-                for (int c = 0; c < (numColsAdd * -1); c++) {
-                    delete_col(currentCanvas, currentCanvas->num_cols - 1);
-                }
-            }     
+        if (numRows > 0 && numCols > 0 && !fits_memory_limit(resized_footprint(currentCanvas, numRows, numCols))) {
+            print_memory_error("Improper resize command.", true);
+            print_canvas(*currentCanvas);
+        }
+        else if (numRows > 0 && numCols > 0) {
+            if (!resize_canvas(currentCanvas, numRows, numCols)) print_memory_error("Improper resize command.", false);
             print_canvas(*currentCanvas);
         }
         else if (numRows == -2) {
             printf("The number of rows is not an integer.\n");
-            while ((c = getchar()) != '\n' && c != EOF);
+            while ((c = getc(command_input())) != '\n' && c != EOF);
         }
-        else if (numRows == -1) {
+        else if (numRows < 0) {
             printf("The number of rows is less than 1.\n");
-            while ((c = getchar()) != '\n' && c != EOF);
+            while ((c = getc(command_input())) != '\n' && c != EOF);
         }
         else if (numCols == -2) {
             printf("The number of columns is not an integer.\n");
-            while ((c = getchar()) != '\n' && c != EOF);
+            while ((c = getc(command_input())) != '\n' && c != EOF);
         }
-        else if (numCols == -1) {
+        else if (numCols < 0) {
             printf("The number of columns is less than 1.\n");
-            while ((c = getchar()) != '\n' && c != EOF);
+            while ((c = getc(command_input())) != '\n' && c != EOF);
         }
         else {
             printf("Improper resize command.\n");
@@ -424,24 +712,40 @@ void resize(canvas* currentCanvas) {
 }
 
 /**
- * "Saves" a canvas by taking a "name" from the user (if valid) and adding a copy of the currentCanvas canvas struct to savedCanvases, otherwise prints what's wrong
+ * "Saves" a canvas by taking a "name" from the user (if valid) and adding a snapshot of the currentCanvas canvas struct to savedCanvases, otherwise prints what's wrong
+ * The snapshot shares the current rows instead of copying them, so saving takes the same time whatever the number of columns
  * @param savedCanvases : pointer to array of canvas structs representing saved canvases
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
  * @param num_saved_canvases : pointer to int representing the number of canvases saved
  * @return nothing
- * @modifies savedCanvases, num_saved_canvases
+ * @modifies savedCanvases, currentCanvas, num_saved_canvases
  */
 void save_canvas(canvas** savedCanvases, canvas* currentCanvas, int* num_saved_canvases) {
     char* input = getValidStr(false);
     if (input != NULL) {
-        *savedCanvases = realloc(*savedCanvases, (*num_saved_canvases + 1) * sizeof(canvas));
-        *num_saved_canvases += 1;
-        (*savedCanvases)[*num_saved_canvases - 1] = create_canvas(currentCanvas->num_rows, currentCanvas->num_cols);
-         for (int i = 0; i < currentCanvas->num_rows; i++) {
-            strcpy((*savedCanvases)[*num_saved_canvases - 1].pixels[i], currentCanvas->pixels[i]);
-        }
-        (*savedCanvases)[*num_saved_canvases - 1].name = strdup(input);
-        print_canvas(*currentCanvas);    
+        // the snapshot takes the current rows, leaving the current canvas to pay for its own row arrays and segment index again
+        size_t saveBytes = canvas_footprint(currentCanvas) + sizeof(canvas) + currentCanvas->num_rows * ROW_OVERHEAD + strlen(input) + 1
+            + segment_index_footprint(&currentCanvas->segments, currentCanvas->num_rows, currentCanvas->num_cols);
+        canvas* grown = NULL;
+        if (!fits_memory_limit(saveBytes)) {
+            print_memory_error("Improper save command or file could not be created.", true);
+        }
+        else if ((grown = (canvas*)realloc(*savedCanvases, (*num_saved_canvases + 1) * sizeof(canvas))) == NULL) {
+            print_memory_error("Improper save command or file could not be created.", false);
+        }
+        else {
+            *savedCanvases = grown;
+            canvas snapshot = snapshot_canvas(currentCanvas, input);
+            if (snapshot.name == NULL) {
+                free_canvas(&snapshot);
+                print_memory_error("Improper save command or file could not be created.", false);
+            }
+            else {
+                *num_saved_canvases += 1;
+                (*savedCanvases)[*num_saved_canvases - 1] = snapshot;
+                print_canvas(*currentCanvas);    
+            }
+        }
     } else {
         printf("Improper save command or file could not be created.\n");
     }
@@ -449,24 +753,41 @@ void save_canvas(canvas** savedCanvases, canvas* currentCanvas, int* num_saved_c
 }
 
 /**
- * "Loads" a canvas by taking a "name" from the user (if valid) and setting currentCanvas to the name matching canvas from SavedCanvases (after printing it), otherwise prints what's wrong
+ * "Loads" a canvas by taking a "name" from the user (if valid) and replacing currentCanvas with a canvas sharing the rows of the name matching canvas from SavedCanvases (after printing it), otherwise prints what's wrong
  * @param savedCanvases : array of canvas structs representing saved canvases
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
- * @param num_saved_canvases : pointer to int representing the number of canvases saved
- * @param canvasLoaded : pointer to int representing index of the canvas "loaded" in savedCanvases
+ * @param num_saved_canvases : int representing the number of canvases saved
  * @return nothing
- * @modifies savedCanvases, currentCanvas, num_saved_canvases, canvasLoaded
+ * @modifies currentCanvas
  */
-void load_canvas(canvas* savedCanvases, canvas* currentCanvas, int num_saved_canvases, int* canvasLoaded) {
+void load_canvas(canvas* savedCanvases, canvas* currentCanvas, int num_saved_canvases) {
     char* input = getValidStr(false);
     bool fileFound = false;
-    if (strcmp(input, "Invalid") != 0) {
+    if (input != NULL) {
         for (int i = 0; i < num_saved_canvases; i++) {
             if (strcmp(input, savedCanvases[i].name) == 0) {
-                print_canvas(savedCanvases[i]); 
-                *currentCanvas = savedCanvases[i];
-                *canvasLoaded = i;
                 fileFound = true;
+                // the loaded canvas shares the saved rows, so it only needs its own row arrays, name and segment index
+                size_t loadBytes = sizeof(canvas) + savedCanvases[i].num_rows * ROW_OVERHEAD + strlen(savedCanvases[i].name) + 1
+                    + segment_index_footprint(&savedCanvases[i].segments, savedCanvases[i].num_rows, savedCanvases[i].num_cols);
+                if (!fits_memory_limit(loadBytes)) {
+                    print_memory_error("Improper load command or file could not be opened.", true);
+                    break;
+                }
+                canvas loaded = share_canvas(&savedCanvases[i]);
+                if (loaded.num_rows != savedCanvases[i].num_rows) {
+                    free_canvas(&loaded);
+                    print_memory_error("Improper load command or file could not be opened.", false);
+                    break;
+                }
+                // a canvas of the same size only shows the rows that differ from the one it replaces
+                bool sameSize = loaded.num_rows == currentCanvas->num_rows && loaded.num_cols == currentCanvas->num_cols;
+                for (int r = 0; r < loaded.num_rows; r++) {
+                    if (!sameSize || !rows_match(loaded.pixels[r], currentCanvas->pixels[r], loaded.num_cols)) mark_row_changed(&loaded, r);
+                }
+                free_canvas(currentCanvas);
+                *currentCanvas = loaded;
+                print_canvas(*currentCanvas); 
                 break;
             }
         } 
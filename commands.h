@@ -6,21 +6,33 @@
 #ifndef COMMANDS_H
 #define COMMANDS_H
 
-void quit(canvas* currentCanvas, canvas* savedCanvases, int num_saved_canvases, int canvasLoaded);
+void quit(canvas* currentCanvas, canvas* savedCanvases, int num_saved_canvases);
 void write(canvas* currentCanvas);
-void draw_horizontal_line(point firstPoint, point secondPoint, canvas* currentCanvas);
-void draw_vertical_line(point firstPoint, point secondPoint, canvas* currentCanvas);
-void draw_left_diagonal_line(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_horizontal_line(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_vertical_line(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_left_diagonal_line(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_right_diagonal_line(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_horizontal_line_cells(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_vertical_line_cells(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_left_diagonal_line_cells(point firstPoint, point secondPoint, canvas* currentCanvas);
+bool draw_right_diagonal_line_cells(point firstPoint, point secondPoint, canvas* currentCanvas);
 void erase(canvas* currentCanvas);
+void erase_line(canvas* currentCanvas);
+void find(canvas* currentCanvas);
+bool resize_canvas(canvas* currentCanvas, int numRows, int numCols);
 void resize(canvas* currentCanvas);
-void add_row(canvas* currentCanvas, int rowPos);
-void add_col(canvas* currentCanvas, int colPos);
+bool add_row(canvas* currentCanvas, int rowPos);
+bool add_col(canvas* currentCanvas, int colPos);
 void add(canvas* currentCanvas);
-void delete_row(canvas* currentCanvas, int rowPos);
-void delete_col(canvas* currentCanvas, int colPos);
+bool delete_row(canvas* currentCanvas, int rowPos);
+bool delete_col(canvas* currentCanvas, int colPos);
 void delete(canvas* currentCanvas); 
 void print_help();
+void output(canvas* currentCanvas);
+void print_memory_error(char* improperMessage, bool overLimit);
+void memory(canvas* currentCanvas);
+void batch(canvas* currentCanvas);
 void save_canvas(canvas** savedCanvases, canvas* currentCanvas, int* num_saved_canvases);
-void load_canvas(canvas* savedCanvases, canvas* currentCanvas, int num_saved_canvases, int* canvasLoaded);
+void load_canvas(canvas* savedCanvases, canvas* currentCanvas, int num_saved_canvases);
 
 #endif
\ No newline at end of file
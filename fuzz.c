@@ -0,0 +1,816 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "commands.h"
+#include "canvas.h"
+#include "input.h"
+
+#define FUZZ_STREAMS 300
+#define FUZZ_COMMANDS 300
+#define FUZZ_WINDOW 16
+#define MAX_REFERENCE_SIZE 48
+#define MAX_REFERENCE_SAVES (FUZZ_COMMANDS + 1)
+#define MAX_LINE 64
+
+// one line drawn on the reference, as the cells left of it (x[i], y[i]) in order from its first cell, each (dx, dy) on from the one before it was drawn
+typedef struct reference_line_struct{
+    int dx;
+    int dy;
+    int num_cells;
+    int x[MAX_REFERENCE_SIZE];
+    int y[MAX_REFERENCE_SIZE];
+} reference_line;
+
+// a canvas kept as a plain grid, cells[y][x] with y counted from the bottom like the commands count it,
+// and the lines drawn on it kept as lists of cells (lines holding room for FUZZ_COMMANDS lines, or just num_lines in a saved reference)
+typedef struct reference_struct{
+    int num_rows;
+    int num_cols;
+    char cells[MAX_REFERENCE_SIZE][MAX_REFERENCE_SIZE];
+    reference_line* lines;
+    int num_lines;
+} reference;
+
+// the canvas and saved canvases one run of a command stream works on
+typedef struct fuzz_run_struct{
+    canvas current;
+    canvas* saved;
+    int num_saved;
+} fuzz_run;
+
+static reference references[MAX_REFERENCE_SAVES];
+static char reference_names[MAX_REFERENCE_SAVES][MAX_LINE];
+static int num_references = 0;
+
+/**
+ * Picks a random int
+ * @param low : int representing the smallest value
+ * @param high : int representing the largest value
+ * @return a random int from low to high (inclusive)
+ */
+static int random_int(int low, int high) {
+    return low + rand() % (high - low + 1);
+}
+
+/**
+ * Marks one cell of the reference with a line glyph the way the draw commands do
+ * @param cell : pointer to the char representing the cell
+ * @param glyph : char representing the glyph of the line
+ * @return nothing
+ * @modifies cell
+ */
+static void reference_mark(char* cell, char glyph) {
+    if (*cell == BACKGROUND) *cell = glyph;
+    else if (*cell != glyph) *cell = '+';
+}
+
+/**
+ * Runs a write command on the reference
+ * @param ref : pointer to reference struct representing the canvas
+ * @param row1 : int representing the row of the first point
+ * @param col1 : int representing the column of the first point
+ * @param row2 : int representing the row of the second point
+ * @param col2 : int representing the column of the second point
+ * @return nothing
+ * @modifies ref
+ */
+static void reference_write(reference* ref, int row1, int col1, int row2, int col2) {
+    if (row1 < 0 || col1 < 0 || row2 < 0 || col2 < 0) return;
+    if (row1 >= ref->num_rows || row2 >= ref->num_rows || col1 >= ref->num_cols || col2 >= ref->num_cols) return;
+    int dRow = row2 - row1;
+    int dCol = col2 - col1;
+    char glyph;
+    if (dRow == 0) glyph = '-';
+    else if (dCol == 0) glyph = '|';
+    else if (dRow == dCol) glyph = '/';
+    else if (dRow == -dCol) glyph = '\\';
+    else return;
+    int stepRow = (dRow > 0) - (dRow < 0);
+    int stepCol = (dCol > 0) - (dCol < 0);
+    int length = (abs(dRow) > abs(dCol)) ? abs(dRow) : abs(dCol);
+    for (int i = 0; i <= length; i++) {
+        reference_mark(&ref->cells[row1 + i * stepRow][col1 + i * stepCol], glyph);
+    }
+    // a line is kept from its left end, or its bottom end if it is vertical
+    bool fromSecond = stepCol < 0 || (stepCol == 0 && stepRow < 0);
+    reference_line* line = &ref->lines[ref->num_lines++];
+    line->dx = (stepCol != 0 || stepRow == 0) ? 1 : 0;
+    line->dy = fromSecond ? -stepRow : stepRow;
+    line->num_cells = length + 1;
+    for (int i = 0; i <= length; i++) {
+        line->x[i] = fromSecond ? col2 - i * stepCol : col1 + i * stepCol;
+        line->y[i] = fromSecond ? row2 - i * stepRow : row1 + i * stepRow;
+    }
+}
+
+/**
+ * Gets the glyph a reference line draws
+ * @param line : pointer to reference_line struct representing the line
+ * @return '-', '|', '/' or '\\'
+ */
+static char reference_glyph(const reference_line* line) {
+    if (line->dy == 0) return '-';
+    if (line->dx == 0) return '|';
+    return (line->dy == 1) ? '/' : '\\';
+}
+
+/**
+ * Changes the cells of every line on the reference the way a command changes the canvas's cells, dropping lines left with no cells
+ * @param ref : pointer to reference struct representing the canvas
+ * @param command : char representing 'a' or 'd' (adding or deleting the row y or column x), 'r' (keeping the first y rows and x columns) or 'e' (erasing the cell (x, y))
+ * @param selection : char representing 'r' (row) or 'c' (column) for 'a' and 'd'
+ * @param editX : int representing the column
+ * @param editY : int representing the row
+ * @return nothing
+ * @modifies ref
+ */
+static void reference_edit_lines(reference* ref, char command, char selection, int editX, int editY) {
+    int numLines = 0;
+    for (int l = 0; l < ref->num_lines; l++) {
+        reference_line line = ref->lines[l];
+        int numCells = 0;
+        for (int i = 0; i < line.num_cells; i++) {
+            int x = line.x[i];
+            int y = line.y[i];
+            int* moved = (selection == 'r') ? &y : &x;
+            int pos = (selection == 'r') ? editY : editX;
+            if (command == 'e' && x == editX && y == editY) continue;
+            if (command == 'r' && (x >= editX || y >= editY)) continue;
+            if (command == 'd' && *moved == pos) continue;
+            if (command == 'd' && *moved > pos) (*moved)--;
+            if (command == 'a' && *moved >= pos) (*moved)++;
+            line.x[numCells] = x;
+            line.y[numCells] = y;
+            numCells++;
+        }
+        line.num_cells = numCells;
+        if (numCells > 0) ref->lines[numLines++] = line;
+    }
+    ref->num_lines = numLines;
+}
+
+/**
+ * Checks if a reference line has a cell
+ * @param line : pointer to reference_line struct representing the line
+ * @param x : int representing the column of the cell
+ * @param y : int representing the row of the cell
+ * @return true if the cell is one of the line's
+ */
+static bool reference_line_covers(const reference_line* line, int x, int y) {
+    for (int i = 0; i < line->num_cells; i++) {
+        if (line->x[i] == x && line->y[i] == y) return true;
+    }
+    return false;
+}
+
+/**
+ * Runs an erase line command on the reference, redrawing each cell of the lines erased from the lines left
+ * @param ref : pointer to reference struct representing the canvas
+ * @param row : int representing the row of the cell
+ * @param col : int representing the column of the cell
+ * @return nothing
+ * @modifies ref
+ */
+static void reference_erase_line(reference* ref, int row, int col) {
+    if (row < 0 || col < 0 || row >= ref->num_rows || col >= ref->num_cols) return;
+    bool redraw[MAX_REFERENCE_SIZE][MAX_REFERENCE_SIZE] = {{false}};
+    int numLines = 0;
+    for (int l = 0; l < ref->num_lines; l++) {
+        if (!reference_line_covers(&ref->lines[l], col, row)) ref->lines[numLines++] = ref->lines[l];
+        else {
+            for (int i = 0; i < ref->lines[l].num_cells; i++) redraw[ref->lines[l].y[i]][ref->lines[l].x[i]] = true;
+        }
+    }
+    ref->num_lines = numLines;
+    for (int y = 0; y < ref->num_rows; y++) {
+        for (int x = 0; x < ref->num_cols; x++) {
+            if (!redraw[y][x]) continue;
+            ref->cells[y][x] = BACKGROUND;
+            for (int l = 0; l < ref->num_lines; l++) {
+                if (reference_line_covers(&ref->lines[l], x, y)) reference_mark(&ref->cells[y][x], reference_glyph(&ref->lines[l]));
+            }
+        }
+    }
+}
+
+/**
+ * Runs a resize command on the reference, which keeps the bottom left of the canvas
+ * @param ref : pointer to reference struct representing the canvas
+ * @param numRows : int representing the new number of rows
+ * @param numCols : int representing the new number of columns
+ * @return nothing
+ * @modifies ref
+ */
+static void reference_resize(reference* ref, int numRows, int numCols) {
+    if (numRows < 1 || numCols < 1) return;
+    for (int y = 0; y < numRows; y++) {
+        for (int x = 0; x < numCols; x++) {
+            if (y >= ref->num_rows || x >= ref->num_cols) ref->cells[y][x] = BACKGROUND;
+        }
+    }
+    ref->num_rows = numRows;
+    ref->num_cols = numCols;
+    reference_edit_lines(ref, 'r', ' ', numCols, numRows);
+}
+
+/**
+ * Runs an add command on the reference
+ * @param ref : pointer to reference struct representing the canvas
+ * @param isRow : true to add a row, false to add a column
+ * @param pos : int representing the row or column the new one is added at
+ * @return nothing
+ * @modifies ref
+ */
+static void reference_add(reference* ref, bool isRow, int pos) {
+    if (isRow && pos >= 0 && pos <= ref->num_rows) {
+        memmove(ref->cells[pos + 1], ref->cells[pos], (ref->num_rows - pos) * sizeof(ref->cells[0]));
+        memset(ref->cells[pos], BACKGROUND, sizeof(ref->cells[0]));
+        ref->num_rows++;
+        reference_edit_lines(ref, 'a', 'r', 0, pos);
+    }
+    else if (!isRow && pos >= 0 && pos <= ref->num_cols) {
+        for (int y = 0; y < ref->num_rows; y++) {
+            memmove(&ref->cells[y][pos + 1], &ref->cells[y][pos], ref->num_cols - pos);
+            ref->cells[y][pos] = BACKGROUND;
+        }
+        ref->num_cols++;
+        reference_edit_lines(ref, 'a', 'c', pos, 0);
+    }
+}
+
+/**
+ * Runs a delete command on the reference
+ * @param ref : pointer to reference struct representing the canvas
+ * @param isRow : true to delete a row, false to delete a column
+ * @param pos : int representing the row or column deleted
+ * @return nothing
+ * @modifies ref
+ */
+static void reference_delete(reference* ref, bool isRow, int pos) {
+    if (isRow && pos >= 0 && pos < ref->num_rows) {
+        memmove(ref->cells[pos], ref->cells[pos + 1], (ref->num_rows - pos - 1) * sizeof(ref->cells[0]));
+        ref->num_rows--;
+        reference_edit_lines(ref, 'd', 'r', 0, pos);
+    }
+    else if (!isRow && pos >= 0 && pos < ref->num_cols) {
+        for (int y = 0; y < ref->num_rows; y++) {
+            memmove(&ref->cells[y][pos], &ref->cells[y][pos + 1], ref->num_cols - pos - 1);
+        }
+        ref->num_cols--;
+        reference_edit_lines(ref, 'd', 'c', pos, 0);
+    }
+}
+
+/**
+ * Runs one line of input on the reference, lines that are not proper commands change nothing
+ * @param ref : pointer to reference struct representing the canvas
+ * @param line : string representing the line
+ * @return nothing
+ * @modifies ref, the saved references
+ */
+static void reference_command(reference* ref, const char* line) {
+    int a, b, c, d;
+    char selection;
+    char name[MAX_LINE];
+    char extra;
+    if (sscanf(line, "w %d %d %d %d %c", &a, &b, &c, &d, &extra) == 4) {
+        reference_write(ref, a, b, c, d);
+    }
+    else if (sscanf(line, "e %d %d %c", &a, &b, &extra) == 2) {
+        if (a >= 0 && b >= 0 && a < ref->num_rows && b < ref->num_cols) {
+            ref->cells[a][b] = BACKGROUND;
+            reference_edit_lines(ref, 'e', ' ', b, a);
+        }
+    }
+    else if (sscanf(line, "x %d %d %c", &a, &b, &extra) == 2) {
+        reference_erase_line(ref, a, b);
+    }
+    else if (sscanf(line, "r %d %d %c", &a, &b, &extra) == 2) {
+        reference_resize(ref, a, b);
+    }
+    else if (sscanf(line, "a %c %d %c", &selection, &a, &extra) == 2 && (selection == 'r' || selection == 'c')) {
+        reference_add(ref, selection == 'r', a);
+    }
+    else if (sscanf(line, "d %c %d %c", &selection, &a, &extra) == 2 && (selection == 'r' || selection == 'c')) {
+        reference_delete(ref, selection == 'r', a);
+    }
+    else if (sscanf(line, "s %63s %c", name, &extra) == 1) {
+        references[num_references] = *ref;
+        references[num_references].lines = (reference_line*)malloc((ref->num_lines + 1) * sizeof(reference_line));
+        if (references[num_references].lines == NULL) {
+            fprintf(stderr, "Could not save a reference.\n");
+            exit(1);
+        }
+        memcpy(references[num_references].lines, ref->lines, ref->num_lines * sizeof(reference_line));
+        strcpy(reference_names[num_references], name);
+        num_references++;
+    }
+    else if (sscanf(line, "l %63s %c", name, &extra) == 1) {
+        for (int i = 0; i < num_references; i++) {
+            if (strcmp(reference_names[i], name) == 0) {
+                reference_line* lines = ref->lines;
+                *ref = references[i];
+                ref->lines = lines;
+                memcpy(ref->lines, references[i].lines, references[i].num_lines * sizeof(reference_line));
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Checks a canvas against the reference cell by cell
+ * @param currentCanvas : canvas struct representing the canvas the commands made
+ * @param ref : pointer to reference struct representing the canvas it should be
+ * @return true if they have the same size and every cell matches
+ */
+static bool matches_reference(canvas currentCanvas, const reference* ref) {
+    if (currentCanvas.num_rows != ref->num_rows || currentCanvas.num_cols != ref->num_cols) return false;
+    for (int y = 0; y < ref->num_rows; y++) {
+        char* row = currentCanvas.pixels[currentCanvas.num_rows - y - 1];
+        for (int x = 0; x < ref->num_cols; x++) {
+            char pixel = (row == NULL) ? BACKGROUND : row[x];
+            if (pixel != ref->cells[y][x]) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Orders pieces of lines by their first cell (bottom row first, then left to right), then direction and length
+ * @param first : pointer to the first segment struct
+ * @param second : pointer to the second segment struct
+ * @return negative, zero or positive as first comes before, with or after second
+ */
+static int compare_pieces(const void* first, const void* second) {
+    const segment* a = (const segment*)first;
+    const segment* b = (const segment*)second;
+    if (a->y != b->y) return a->y - b->y;
+    if (a->x != b->x) return a->x - b->x;
+    if (a->dx != b->dx) return a->dx - b->dx;
+    if (a->dy != b->dy) return a->dy - b->dy;
+    return a->length - b->length;
+}
+
+/**
+ * Orders strings alphabetically
+ * @param first : pointer to the first string
+ * @param second : pointer to the second string
+ * @return negative, zero or positive as first comes before, with or after second
+ */
+static int compare_strings(const void* first, const void* second) {
+    return strcmp(*(char* const*)first, *(char* const*)second);
+}
+
+/**
+ * Writes the pieces of a line as a string, so lines can be compared whatever order their pieces are kept in
+ * @param pieces : array of segment structs representing the pieces, sorted by the call
+ * @param numPieces : int representing the number of pieces
+ * @return the string, allocated with malloc
+ */
+static char* pieces_signature(segment* pieces, int numPieces) {
+    qsort(pieces, numPieces, sizeof(segment), compare_pieces);
+    char* signature = (char*)malloc(numPieces * 64 + 1);
+    if (signature == NULL) {
+        fprintf(stderr, "Could not compare the lines.\n");
+        exit(1);
+    }
+    signature[0] = '\0';
+    for (int p = 0; p < numPieces; p++) {
+        sprintf(signature + strlen(signature), "%d,%d,%d,%d,%d;", pieces[p].x, pieces[p].y, pieces[p].dx, pieces[p].dy, pieces[p].length);
+    }
+    return signature;
+}
+
+/**
+ * Splits a reference line into the runs of cells that carry straight on from each other, which are the pieces the segment index should keep
+ * @param line : pointer to reference_line struct representing the line
+ * @param pieces : array of segment structs to fill, room for line->num_cells
+ * @return the number of pieces
+ * @modifies pieces
+ */
+static int reference_pieces(const reference_line* line, segment* pieces) {
+    int numPieces = 0;
+    for (int i = 0; i < line->num_cells; i++) {
+        if (i > 0 && line->x[i] == line->x[i - 1] + line->dx && line->y[i] == line->y[i - 1] + line->dy) pieces[numPieces - 1].length++;
+        else pieces[numPieces++] = create_segment(line->x[i], line->y[i], line->dx, line->dy, 1);
+    }
+    return numPieces;
+}
+
+/**
+ * Sorts strings and frees the repeats
+ * @param strings : array of strings allocated with malloc
+ * @param numStrings : int representing the number of strings
+ * @return the number of different strings, moved to the front of strings
+ * @modifies strings
+ */
+static int unique_strings(char** strings, int numStrings) {
+    qsort(strings, numStrings, sizeof(char*), compare_strings);
+    int numUnique = 0;
+    for (int i = 0; i < numStrings; i++) {
+        if (numUnique > 0 && strcmp(strings[numUnique - 1], strings[i]) == 0) free(strings[i]);
+        else strings[numUnique++] = strings[i];
+    }
+    return numUnique;
+}
+
+/**
+ * Checks two lists of strings hold the same strings, freeing both
+ * @param first : array of strings allocated with malloc, itself allocated with malloc
+ * @param numFirst : int representing the number of strings in first
+ * @param second : array of strings allocated with malloc, itself allocated with malloc
+ * @param numSecond : int representing the number of strings in second
+ * @return true if the same strings are in both, repeats aside
+ */
+static bool same_strings(char** first, int numFirst, char** second, int numSecond) {
+    numFirst = unique_strings(first, numFirst);
+    numSecond = unique_strings(second, numSecond);
+    bool same = numFirst == numSecond;
+    for (int i = 0; i < numFirst && same; i++) {
+        if (strcmp(first[i], second[i]) != 0) same = false;
+    }
+    for (int i = 0; i < numFirst; i++) free(first[i]);
+    for (int i = 0; i < numSecond; i++) free(second[i]);
+    free(first);
+    free(second);
+    return same;
+}
+
+/**
+ * Allocates memory for the fuzzer, which gives up if there is none
+ * @param bytes : size_t representing the number of bytes
+ * @return the memory
+ */
+static void* checked_malloc(size_t bytes) {
+    void* memory = malloc(bytes + 1);
+    if (memory == NULL) {
+        fprintf(stderr, "Could not allocate memory for a check.\n");
+        exit(1);
+    }
+    return memory;
+}
+
+/**
+ * Checks the lines in a canvas's segment index against the lines of the reference, comparing each line's pieces
+ * @param currentCanvas : pointer to canvas struct representing the canvas the commands made
+ * @param ref : pointer to reference struct representing the canvas it should be
+ * @return true if the same lines are in both, repeats aside
+ */
+static bool lines_match_reference(canvas* currentCanvas, const reference* ref) {
+    segment_index* index = &currentCanvas->segments;
+    char** found = (char**)checked_malloc(index->num_segments * sizeof(char*));
+    char** expected = (char**)checked_malloc(ref->num_lines * sizeof(char*));
+    bool* visited = (bool*)calloc(index->num_segments + 1, sizeof(bool));
+    segment* pieces = (segment*)checked_malloc((index->num_segments + MAX_REFERENCE_SIZE) * sizeof(segment));
+    int numFound = 0;
+    for (int id = 0; id < index->num_segments && visited != NULL; id++) {
+        if (visited[id]) continue;
+        int numPieces = 0;
+        int piece = id;
+        do {
+            visited[piece] = true;
+            pieces[numPieces++] = index->segments[piece];
+            piece = index->segments[piece].next_piece;
+        } while (piece != id && piece >= 0 && piece < index->num_segments && !visited[piece]);
+        found[numFound++] = pieces_signature(pieces, numPieces);
+    }
+    for (int l = 0; l < ref->num_lines; l++) {
+        expected[l] = pieces_signature(pieces, reference_pieces(&ref->lines[l], pieces));
+    }
+    free(visited);
+    free(pieces);
+    return same_strings(found, numFound, expected, ref->num_lines);
+}
+
+/**
+ * Checks the segment index of a canvas holds together: every piece inside the canvas and linked into a circle with the rest of its line,
+ * every bucket listing exactly the pieces crossing it, the free entries counted right, and the pieces drawing every pixel of the canvas
+ * @param currentCanvas : pointer to canvas struct representing the canvas
+ * @return true if every check passed
+ */
+static bool index_is_consistent(canvas* currentCanvas) {
+    segment_index* index = &currentCanvas->segments;
+    int bucketRows = (currentCanvas->num_rows + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    int bucketCols = (currentCanvas->num_cols + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    if (index->bucket_rows != bucketRows || index->bucket_cols != bucketCols) return false;
+    if (index->num_segments > index->segment_capacity || index->num_entries > index->entry_capacity) return false;
+    int crossings = 0;
+    for (int id = 0; id < index->num_segments; id++) {
+        segment line = index->segments[id];
+        if (line.length < 1 || line.next_piece < 0 || line.next_piece >= index->num_segments) return false;
+        if (index->segments[line.next_piece].prev_piece != id) return false;
+        for (int i = 0; i < line.length; i++) {
+            int x = line.x + i * line.dx;
+            int y = line.y + i * line.dy;
+            if (x < 0 || y < 0 || x >= currentCanvas->num_cols || y >= currentCanvas->num_rows) return false;
+            // cells in the same bucket come one after another along a straight line
+            if (i == 0 || x / BUCKET_SIZE != (x - line.dx) / BUCKET_SIZE || y / BUCKET_SIZE != (y - line.dy) / BUCKET_SIZE) crossings++;
+        }
+    }
+    int listed = 0;
+    for (int by = 0; by < bucketRows; by++) {
+        for (int bx = 0; bx < bucketCols; bx++) {
+            for (int entry = index->buckets[by][bx]; entry != -1; entry = index->entries[entry].next) {
+                int id = index->entries[entry].segment;
+                if (entry < 0 || entry >= index->num_entries || ++listed > index->num_entries) return false;
+                if (id < 0 || id >= index->num_segments) return false;
+                bool crosses = false;
+                segment line = index->segments[id];
+                for (int i = 0; i < line.length; i++) {
+                    if ((line.x + i * line.dx) / BUCKET_SIZE == bx && (line.y + i * line.dy) / BUCKET_SIZE == by) crosses = true;
+                }
+                if (!crosses) return false;
+                for (int other = index->entries[entry].next; other != -1; other = index->entries[other].next) {
+                    if (index->entries[other].segment == id) return false;
+                }
+            }
+        }
+    }
+    int numFree = 0;
+    for (int entry = index->free_entry; entry != -1; entry = index->entries[entry].next) {
+        if (entry < 0 || entry >= index->num_entries || ++numFree > index->num_entries) return false;
+    }
+    if (listed != crossings || numFree != index->num_free_entries || listed + numFree != index->num_entries) return false;
+    for (int y = 0; y < currentCanvas->num_rows; y++) {
+        char* row = currentCanvas->pixels[currentCanvas->num_rows - y - 1];
+        for (int x = 0; x < currentCanvas->num_cols; x++) {
+            if (glyph_at(index, x, y) != ((row == NULL) ? BACKGROUND : row[x])) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks a random region query on a canvas against the pieces of the reference's lines crossing the region
+ * @param currentCanvas : pointer to canvas struct representing the canvas the commands made
+ * @param ref : pointer to reference struct representing the canvas it should be
+ * @return true if the query found the same pieces, repeats aside (or the canvas has no cells to query)
+ */
+static bool query_matches_reference(canvas* currentCanvas, const reference* ref) {
+    if (ref->num_rows == 0 || ref->num_cols == 0) return true;
+    int x1 = random_int(0, ref->num_cols - 1);
+    int x2 = random_int(0, ref->num_cols - 1);
+    int y1 = random_int(0, ref->num_rows - 1);
+    int y2 = random_int(0, ref->num_rows - 1);
+    int xLow = (x1 < x2) ? x1 : x2;
+    int xHigh = (x1 < x2) ? x2 : x1;
+    int yLow = (y1 < y2) ? y1 : y2;
+    int yHigh = (y1 < y2) ? y2 : y1;
+    segment* found;
+    int numFound = find_segments(&currentCanvas->segments, xLow, yLow, xHigh, yHigh, &found);
+    if (numFound < 0) {
+        fprintf(stderr, "Could not run a query.\n");
+        exit(1);
+    }
+    char** foundPieces = (char**)checked_malloc(numFound * sizeof(char*));
+    for (int f = 0; f < numFound; f++) foundPieces[f] = pieces_signature(&found[f], 1);
+    free(found);
+    char** expected = (char**)checked_malloc(ref->num_lines * MAX_REFERENCE_SIZE * sizeof(char*));
+    segment pieces[MAX_REFERENCE_SIZE];
+    int numExpected = 0;
+    for (int l = 0; l < ref->num_lines; l++) {
+        int numPieces = reference_pieces(&ref->lines[l], pieces);
+        for (int p = 0; p < numPieces; p++) {
+            bool crosses = false;
+            for (int i = 0; i < pieces[p].length; i++) {
+                int x = pieces[p].x + i * pieces[p].dx;
+                int y = pieces[p].y + i * pieces[p].dy;
+                if (x >= xLow && x <= xHigh && y >= yLow && y <= yHigh) crosses = true;
+            }
+            if (crosses) expected[numExpected++] = pieces_signature(&pieces[p], 1);
+        }
+    }
+    return same_strings(foundPieces, numFound, expected, numExpected);
+}
+
+/**
+ * Checks a run, including every canvas it saved and the lines in their segment indexes, against the reference
+ * @param run : pointer to fuzz_run struct representing the run
+ * @param ref : pointer to reference struct representing the canvas it should have
+ * @return true if the canvas and every saved canvas match
+ */
+static bool run_matches_reference(fuzz_run* run, const reference* ref) {
+    if (!matches_reference(run->current, ref) || !lines_match_reference(&run->current, ref) || run->num_saved != num_references) return false;
+    for (int i = 0; i < run->num_saved; i++) {
+        if (strcmp(run->saved[i].name, reference_names[i]) != 0 || !matches_reference(run->saved[i], &references[i])
+            || !lines_match_reference(&run->saved[i], &references[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * Prints a canvas and the reference it should match to stderr
+ * @param currentCanvas : canvas struct representing the canvas the commands made
+ * @param ref : pointer to reference struct representing the canvas it should be
+ * @return nothing
+ */
+static void print_mismatch(canvas currentCanvas, const reference* ref) {
+    fprintf(stderr, "canvas %d x %d:\n", currentCanvas.num_rows, currentCanvas.num_cols);
+    for (int r = 0; r < currentCanvas.num_rows; r++) {
+        for (int x = 0; x < currentCanvas.num_cols; x++) {
+            char pixel = (currentCanvas.pixels[r] == NULL) ? BACKGROUND : currentCanvas.pixels[r][x];
+            fputc((pixel == BACKGROUND) ? '*' : pixel, stderr);
+        }
+        fputc('\n', stderr);
+    }
+    fprintf(stderr, "reference %d x %d:\n", ref->num_rows, ref->num_cols);
+    for (int y = ref->num_rows - 1; y >= 0; y--) {
+        for (int x = 0; x < ref->num_cols; x++) {
+            fputc((ref->cells[y][x] == BACKGROUND) ? '*' : ref->cells[y][x], stderr);
+        }
+        fputc('\n', stderr);
+    }
+}
+
+/**
+ * Runs one line of input through getValidCommand, the same way batch mode runs a line
+ * @param run : pointer to fuzz_run struct representing the canvas and saved canvases to run it on
+ * @param line : string representing the line
+ * @return nothing
+ * @modifies run
+ */
+static void run_line(fuzz_run* run, char* line) {
+    FILE* stream = fmemopen(line, strlen(line), "r");
+    if (stream == NULL) {
+        fprintf(stderr, "Could not open a stream for a command.\n");
+        exit(1);
+    }
+    set_command_input(stream);
+    getValidCommand(false, &run->current, &run->saved, &run->num_saved);
+    set_command_input(NULL);
+    fclose(stream);
+}
+
+/**
+ * Frees a run
+ * @param run : pointer to fuzz_run struct representing the run
+ * @return nothing
+ * @modifies run
+ */
+static void free_run(fuzz_run* run) {
+    free_canvas(&run->current);
+    for (int i = 0; i < run->num_saved; i++) {
+        free_canvas(&run->saved[i]);
+    }
+    free(run->saved);
+}
+
+/**
+ * Makes a random line of input, mostly proper commands near the edges of the canvas and sometimes improper ones
+ * @param line : string representing where the line is written, at least MAX_LINE chars
+ * @param ref : pointer to reference struct representing the canvas the line will run on
+ * @return nothing
+ * @modifies line
+ */
+static void random_line(char* line, const reference* ref) {
+    int rows = ref->num_rows;
+    int cols = ref->num_cols;
+    bool canGrow = rows < MAX_REFERENCE_SIZE - 1 && cols < MAX_REFERENCE_SIZE - 1;
+    int kind = random_int(0, 99);
+    if (kind < 35) {
+        int row1 = random_int(0, rows);
+        int col1 = random_int(0, cols);
+        int row2 = row1;
+        int col2 = col1;
+        int length = random_int(-rows, rows);
+        int shape = random_int(0, 4);
+        if (shape == 0) col2 += length;
+        else if (shape == 1) row2 += length;
+        else if (shape == 2) { row2 += length; col2 += length; }
+        else if (shape == 3) { row2 += length; col2 -= length; }
+        else { row2 = random_int(0, rows); col2 = random_int(0, cols); }
+        if (random_int(0, 19) == 0) row1 = -random_int(1, 3);
+        if (random_int(0, 19) == 0) col2 = -random_int(1, 3);
+        sprintf(line, "w %d %d %d %d", row1, col1, row2, col2);
+    }
+    else if (kind < 43) {
+        sprintf(line, "e %d %d", random_int(-2, rows), random_int(-2, cols));
+    }
+    else if (kind < 47) {
+        // mostly a cell of a line, so lines are often erased
+        int row = random_int(-1, rows);
+        int col = random_int(-1, cols);
+        if (ref->num_lines > 0 && random_int(0, 3) > 0) {
+            const reference_line* picked = &ref->lines[random_int(0, ref->num_lines - 1)];
+            int i = random_int(0, picked->num_cells - 1);
+            row = picked->y[i];
+            col = picked->x[i];
+        }
+        sprintf(line, "x %d %d", row, col);
+    }
+    else if (kind < 55) {
+        int limit = canGrow ? 20 : 10;
+        sprintf(line, "r %d %d", random_int(-3, limit), random_int(-3, limit));
+    }
+    else if (kind < 67 && canGrow) {
+        if (random_int(0, 1) == 0) sprintf(line, "a r %d", random_int(-1, rows + 1));
+        else sprintf(line, "a c %d", random_int(-1, cols + 1));
+    }
+    else if (kind < 79) {
+        if (random_int(0, 1) == 0) sprintf(line, "d r %d", random_int(-1, rows));
+        else sprintf(line, "d c %d", random_int(-1, cols));
+    }
+    else if (kind < 86) {
+        sprintf(line, "s n%d", random_int(0, 3));
+    }
+    else if (kind < 93) {
+        sprintf(line, "l n%d", random_int(0, 4));
+    }
+    else if (kind < 96) {
+        const char* other[] = {"p", "o d", "o f", "h"};
+        int pick = random_int(0, 4);
+        if (pick < 4) strcpy(line, other[pick]);
+        else sprintf(line, "f %d %d %d %d", random_int(-1, rows), random_int(-1, cols), random_int(0, rows), random_int(0, cols));
+    }
+    else {
+        const char* improper[] = {"w 1 2", "w a 1 2 3", "e 1", "r 0 5", "r 3 x", "a q 1", "a r", "d c", "d r x", "l", "z", "s", "x 1", "f 1 2 3"};
+        strcpy(line, improper[random_int(0, 13)]);
+    }
+}
+
+/**
+ * Runs one random command stream through the commands and the reference, checking the canvases after every line,
+ * and runs it again in windows coalesced by coalesce_commands, checking the canvases after every window
+ * @param seed : unsigned int representing the seed of the stream
+ * @return true if every check passed
+ */
+static bool fuzz_stream(unsigned int seed) {
+    char lines[FUZZ_COMMANDS][MAX_LINE];
+    reference ref;
+    srand(seed);
+    fuzz_run direct = {create_canvas(random_int(1, 12), random_int(1, 12)), NULL, 0};
+    fuzz_run coalesced = {create_canvas(direct.current.num_rows, direct.current.num_cols), NULL, 0};
+    bool passed = true;
+    ref.num_rows = direct.current.num_rows;
+    ref.num_cols = direct.current.num_cols;
+    memset(ref.cells, BACKGROUND, sizeof(ref.cells));
+    ref.lines = (reference_line*)checked_malloc(FUZZ_COMMANDS * sizeof(reference_line));
+    ref.num_lines = 0;
+    num_references = 0;
+    for (int i = 0; i < FUZZ_COMMANDS && passed; i++) {
+        random_line(lines[i], &ref);
+        run_line(&direct, lines[i]);
+        reference_command(&ref, lines[i]);
+        if (!run_matches_reference(&direct, &ref)) {
+            fprintf(stderr, "seed %u: line %d \"%s\" does not match the reference\n", seed, i + 1, lines[i]);
+            print_mismatch(direct.current, &ref);
+            passed = false;
+        }
+        else if (!index_is_consistent(&direct.current)) {
+            fprintf(stderr, "seed %u: line %d \"%s\" leaves the segment index inconsistent\n", seed, i + 1, lines[i]);
+            passed = false;
+        }
+        else if (!query_matches_reference(&direct.current, &ref)) {
+            fprintf(stderr, "seed %u: a query after line %d \"%s\" does not match the reference\n", seed, i + 1, lines[i]);
+            passed = false;
+        }
+        if (passed && (i + 1) % FUZZ_WINDOW == 0) {
+            // the window gives the same canvas coalesced, which the direct run just checked against the reference
+            char* window[FUZZ_WINDOW];
+            for (int j = 0; j < FUZZ_WINDOW; j++) {
+                window[j] = strdup(lines[i + 1 - FUZZ_WINDOW + j]);
+            }
+            int numLines = coalesce_commands(window, FUZZ_WINDOW);
+            for (int j = 0; j < numLines; j++) {
+                run_line(&coalesced, window[j]);
+                free(window[j]);
+            }
+            if (!run_matches_reference(&coalesced, &ref)) {
+                fprintf(stderr, "seed %u: the window ending at line %d does not match the reference after coalescing\n", seed, i + 1);
+                print_mismatch(coalesced.current, &ref);
+                passed = false;
+            }
+        }
+    }
+    free_run(&direct);
+    free_run(&coalesced);
+    free(ref.lines);
+    for (int i = 0; i < num_references; i++) {
+        free(references[i].lines);
+    }
+    return passed;
+}
+
+/**
+ * Fuzzes the commands against the reference: ./fuzz.out [number of streams] [first seed]
+ * @param argc : int representing the number of arguments
+ * @param argv : array of strings representing the arguments
+ * @return 0 if every stream matched the reference, 1 otherwise
+ */
+int main(int argc, char** argv) {
+    int numStreams = (argc > 1) ? atoi(argv[1]) : FUZZ_STREAMS;
+    unsigned int firstSeed = (argc > 2) ? (unsigned int)atoi(argv[2]) : 1;
+    int failed = 0;
+    // the commands print every canvas, only the mismatches are reported
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "Could not discard the output of the commands.\n");
+        return 1;
+    }
+    for (int i = 0; i < numStreams; i++) {
+        if (!fuzz_stream(firstSeed + i)) failed++;
+    }
+    fprintf(stderr, "%d of %d command streams matched the reference\n", numStreams - failed, numStreams);
+    return (failed == 0) ? 0 : 1;
+}
@@ -3,10 +3,26 @@
 #include <stdlib.h>
 #include <math.h>
 #include <ctype.h>
+#include <string.h>
 #include "commands.h"
 #include "canvas.h"
 #include "input.h"
 
+// a command read ahead in batch mode, as far as the coalescing stage needs to understand it
+typedef struct batched_command_struct{
+    char command;
+    char selection;
+    int first;
+    int second;
+} batched_command;
+
+static FILE* command_stream = NULL;
+static int batch_window = 0;
+static char* batch_lines[MAX_BATCH_WINDOW];
+static int num_batch_lines = 0;
+static int next_batch_line = 0;
+static char* current_batch_line = NULL;
+
 /**
  * Creates the first canvas struct with the specified dimensions from the command line (if valid), otherwise default to 10 by 10
  * @param argc : int representing number of arguments entered on command line
@@ -36,7 +52,14 @@ canvas create_initial_canvas(int argc, char* argv[]) {
         num_rows = 10;
         num_cols = 10;
     } 
-    return create_canvas(num_rows, num_cols);
+    canvas initialCanvas = create_canvas(num_rows, num_cols);
+    if (initialCanvas.num_rows == 0) {
+        printf("Not enough memory for a board of %d X %d.\n", num_rows, num_cols);
+        printf("Making default board of 10 X 10.\n");
+        free_canvas(&initialCanvas);
+        initialCanvas = create_canvas(10, 10);
+    }
+    return initialCanvas;
 }
 
 /**
@@ -51,7 +74,7 @@ bool isValidFormat(const int num_args_needed, const int num_args_read,
     bool format_is_correct = num_args_read == num_args_needed;
     char last_value;
     if (should_be_last_value_on_line) {
-        while (isspace(last_value = getchar()) && last_value != '\n');
+        while (isspace(last_value = getc(command_input())) && last_value != '\n');
         format_is_correct = format_is_correct && (last_value == '\n' || last_value == EOF);
     }
     return format_is_correct;
@@ -61,17 +84,18 @@ bool isValidFormat(const int num_args_needed, const int num_args_read,
  * Takes a command, or a valid character from the user, to call the appropriate function, otherwise print what's wrong 
  * @param isLastElementOnLine : true if this is the last value that should be on this line of input
  * @param currentCanvas : pointer to canvas struct representing the current canvas being dealt with/modified 
- * @param savedCanvases : array of canvas structs representing saved canvases
+ * @param savedCanvases : pointer to array of canvas structs representing saved canvases
  * @param num_saved_canvases : pointer to int representing the number of canvases saved
  * @return nothing
  * @modifies nothing directly
  */
-void getValidCommand(const bool isLastElementOnLine, canvas* currentCanvas, canvas* savedCanvases, int* num_saved_canvases) {
+void getValidCommand(const bool isLastElementOnLine, canvas* currentCanvas, canvas** savedCanvases, int* num_saved_canvases) {
   const int numArgsNeeded = 1;
   int numArgsRead;
-  char* string = (char*)malloc(25*sizeof(char));
-  int canvasLoaded;
-  numArgsRead = scanf(" %s", string);
+  char string[25];
+  if (!next_batched_command() && batch_window > 0) quit(currentCanvas, *savedCanvases, *num_saved_canvases); // no more input
+  numArgsRead = fscanf(command_input(), " %24s", string);
+  if (numArgsRead == EOF) quit(currentCanvas, *savedCanvases, *num_saved_canvases); // no more input
   if (string[1] == '\0' && isValidFormat(numArgsNeeded, numArgsRead, isLastElementOnLine)) {
     if (string[0] == 'w') write(currentCanvas);
     if (string[0] == 'h') {
@@ -79,26 +103,222 @@ void getValidCommand(const bool isLastElementOnLine, canvas* currentCanvas, canv
         print_canvas(*currentCanvas);
     }
     if (string[0] == 'e') erase(currentCanvas);
+    if (string[0] == 'x') erase_line(currentCanvas);
+    if (string[0] == 'f') find(currentCanvas);
     if (string[0] == 'r') resize(currentCanvas);
     if (string[0] == 'a') add(currentCanvas);
     if (string[0] == 'd') delete(currentCanvas);
-    if (string[0] == 's') save_canvas(&savedCanvases, currentCanvas, num_saved_canvases);
-    if (string[0] == 'l') load_canvas(savedCanvases, currentCanvas, *num_saved_canvases, &canvasLoaded);
-    if (string[0] == 'q') quit(currentCanvas, savedCanvases, *num_saved_canvases, canvasLoaded); 
+    if (string[0] == 's') save_canvas(savedCanvases, currentCanvas, num_saved_canvases);
+    if (string[0] == 'l') load_canvas(*savedCanvases, currentCanvas, *num_saved_canvases);
+    if (string[0] == 'p') print_full_canvas(*currentCanvas);
+    if (string[0] == 'o') output(currentCanvas);
+    if (string[0] == 'm') memory(currentCanvas);
+    if (string[0] == 'b') batch(currentCanvas);
+    if (string[0] == 'q') quit(currentCanvas, *savedCanvases, *num_saved_canvases); 
   }
   else {
     int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+    while ((c = getc(command_input())) != '\n' && c != EOF);
     if (string[0] == 'w') printf("Improper draw command.\n"); 
     else if (string[0] == 'e') printf("Improper erase command.\n");
+    else if (string[0] == 'x') printf("Improper erase line command.\n");
+    else if (string[0] == 'f') printf("Improper find command.\n");
     else if (string[0] == 'r') printf("Improper resize command.\n");
     else if (string[0] == 'a') printf("Improper add command.\n");
     else if (string[0] == 'd') printf("Improper delete command.\n");
     else if (string[0] == 's') printf("Improper save command or file could not be created.\n");
     else if (string[0] == 'l') printf("Improper load command or file could not be opened.\n");
+    else if (string[0] == 'o') printf("Improper output command.\n");
+    else if (string[0] == 'm') printf("Improper memory command.\n");
+    else if (string[0] == 'b') printf("Improper batch command.\n");
     else printf("Unrecognized command. Type h for help.\n"); 
     print_canvas(*currentCanvas);
   }
+  update_peak_footprint(currentCanvas);
+}
+
+/**
+ * Gets the stream commands are read from, which is stdin unless a command read ahead in batch mode is being run
+ * @param none : none
+ * @return the stream to read the current command from
+ */
+FILE* command_input() {
+    if (command_stream != NULL) return command_stream;
+    return stdin;
+}
+
+/**
+ * Reads commands from another stream instead of stdin until set back to NULL
+ * @param stream : stream to read commands from, or NULL for stdin
+ * @return nothing
+ * @modifies which stream commands are read from
+ */
+void set_command_input(FILE* stream) {
+    command_stream = stream;
+}
+
+/**
+ * Sets how many lines of input batch mode reads ahead and coalesces before running them, 0 running each command as it is entered
+ * @param window : int representing the number of lines to read ahead (at most MAX_BATCH_WINDOW)
+ * @return nothing
+ * @modifies the batch window
+ */
+void set_batch_window(int window) {
+    batch_window = window;
+}
+
+/**
+ * Works out what a line of input does if it is a command the coalescing stage can merge or cancel
+ * @param line : string representing the line
+ * @return a batched_command struct, with a command of 'r' (resize), 'a' (add) or 'd' (delete), or '!' for any other line
+ */
+static batched_command parse_batched_command(char* line) {
+    batched_command parsed = {'!', '\0', 0, 0};
+    char command[25];
+    char selection[25];
+    int end = -1;
+    // only lines that hold exactly one valid command are understood, anything else is left to the command's own checks
+    if (sscanf(line, " %24s %d %d %n", command, &parsed.first, &parsed.second, &end) == 3 && line[end] == '\0'
+        && strcmp(command, "r") == 0 && parsed.first > 0 && parsed.second > 0) {
+        parsed.command = 'r';
+    }
+    else if (sscanf(line, " %24s %24s %d %n", command, selection, &parsed.first, &end) == 3 && line[end] == '\0'
+        && (strcmp(command, "a") == 0 || strcmp(command, "d") == 0)
+        && (strcmp(selection, "r") == 0 || strcmp(selection, "c") == 0) && parsed.first >= 0) {
+        parsed.command = command[0];
+        parsed.selection = selection[0];
+    }
+    return parsed;
+}
+
+/**
+ * Coalesces a window of input lines so they give the same canvas while running fewer commands:
+ * an add is cancelled by a delete of the same row or column right after it (including nested pairs),
+ * and consecutive resizes are merged into a resize to the smallest size reached followed by the last resize (one resize if those are the same)
+ * Nothing is coalesced if there is a memory limit, since a command failing under the limit would change what the others do
+ * @param lines : array of strings representing the lines, each allocated with malloc
+ * @param numLines : int representing the number of lines
+ * @return the number of lines left, which are moved to the front of lines (lines removed are freed)
+ * @modifies lines
+ */
+int coalesce_commands(char** lines, int numLines) {
+    batched_command parsed[MAX_BATCH_WINDOW];
+    int kept[MAX_BATCH_WINDOW];
+    int numKept = 0;
+    for (int i = 0; i < numLines; i++) {
+        char command[25];
+        if (sscanf(lines[i], " %24s", command) == 1 && strcmp(command, "m") == 0) return numLines;
+    }
+    if (has_memory_limit()) return numLines;
+    // kept works as a stack, so a delete cancels the add just before it and uncovers the add before that
+    for (int i = 0; i < numLines; i++) {
+        parsed[i] = parse_batched_command(lines[i]);
+        if (numKept > 0 && parsed[i].command == 'd' && parsed[kept[numKept - 1]].command == 'a'
+            && parsed[i].selection == parsed[kept[numKept - 1]].selection && parsed[i].first == parsed[kept[numKept - 1]].first) {
+            free(lines[kept[numKept - 1]]);
+            free(lines[i]);
+            lines[kept[numKept - 1]] = NULL;
+            lines[i] = NULL;
+            numKept--;
+        }
+        else kept[numKept++] = i;
+    }
+    for (int k = 0; k < numKept; k++) {
+        if (parsed[kept[k]].command != 'r') continue;
+        int last = k;
+        int minRows = parsed[kept[k]].first;
+        int minCols = parsed[kept[k]].second;
+        while (last + 1 < numKept && parsed[kept[last + 1]].command == 'r') {
+            last++;
+            if (parsed[kept[last]].first < minRows) minRows = parsed[kept[last]].first;
+            if (parsed[kept[last]].second < minCols) minCols = parsed[kept[last]].second;
+        }
+        // rows and columns cut off by any resize stay cut off, so only the smallest size and the final size matter
+        char* smallestLine = NULL;
+        if (last > k && (minRows != parsed[kept[last]].first || minCols != parsed[kept[last]].second)) {
+            char smallest[64];
+            snprintf(smallest, sizeof(smallest), "r %d %d\n", minRows, minCols);
+            smallestLine = strdup(smallest);
+            if (smallestLine == NULL) last = k; // leave the resizes as they are
+        }
+        for (int j = k; j < last; j++) {
+            free(lines[kept[j]]);
+            lines[kept[j]] = NULL;
+        }
+        if (smallestLine != NULL) lines[kept[k]] = smallestLine;
+        k = last;
+    }
+    int numLeft = 0;
+    for (int i = 0; i < numLines; i++) {
+        if (lines[i] != NULL) lines[numLeft++] = lines[i];
+    }
+    return numLeft;
+}
+
+/**
+ * Reads up to a window of non-blank lines from stdin for batch mode and coalesces them
+ * @param none : none
+ * @return nothing
+ * @modifies the lines waiting to be run
+ */
+static void read_batch() {
+    num_batch_lines = 0;
+    next_batch_line = 0;
+    while (num_batch_lines < batch_window) {
+        char* line = NULL;
+        size_t capacity = 0;
+        if (getline(&line, &capacity, stdin) < 0) {
+            free(line);
+            break;
+        }
+        int i = 0;
+        while (isspace(line[i])) i++;
+        if (line[i] == '\0') free(line);
+        else batch_lines[num_batch_lines++] = line;
+    }
+    num_batch_lines = coalesce_commands(batch_lines, num_batch_lines);
+}
+
+/**
+ * Moves on to the next command read ahead in batch mode (reading more if batch mode is on and none are left), which is then read through command_input
+ * @param none : none
+ * @return true if there is a command read ahead to run, false if commands are read from stdin as they are entered or there is no more input
+ * @modifies which stream commands are read from
+ */
+bool next_batched_command() {
+    if (current_batch_line != NULL) {
+        fclose(command_stream);
+        command_stream = NULL;
+        free(current_batch_line);
+        current_batch_line = NULL;
+    }
+    if (next_batch_line == num_batch_lines && batch_window > 0) read_batch();
+    while (next_batch_line < num_batch_lines) {
+        char* line = batch_lines[next_batch_line++];
+        command_stream = fmemopen(line, strlen(line), "r");
+        if (command_stream != NULL) {
+            current_batch_line = line;
+            return true;
+        }
+        free(line);
+    }
+    return false;
+}
+
+/**
+ * Frees the commands read ahead in batch mode that have not been run
+ * @param none : none
+ * @return nothing
+ * @modifies the lines waiting to be run
+ */
+void free_batch() {
+    if (current_batch_line != NULL) {
+        fclose(command_stream);
+        command_stream = NULL;
+        free(current_batch_line);
+        current_batch_line = NULL;
+    }
+    while (next_batch_line < num_batch_lines) free(batch_lines[next_batch_line++]);
 }
 
 /**
@@ -111,7 +331,7 @@ char* getValidStr(const bool isLastElementOnLine) {
   int numArgsRead;
   char* string = (char*)malloc(25*sizeof(char));
 
-  numArgsRead = scanf(" %s", string);
+  numArgsRead = fscanf(command_input(), " %24s", string);
   if (isValidFormat(numArgsNeeded, numArgsRead, isLastElementOnLine)) {
     return string;
   } else {
@@ -130,7 +350,7 @@ int getValidInt(const bool isLastElementOnLine) {
   int numArgsRead;
   int num;
 
-  numArgsRead = scanf(" %d", &num);
+  numArgsRead = fscanf(command_input(), " %d", &num);
   
   if (isValidFormat(numArgsNeeded, numArgsRead, isLastElementOnLine)) {
     return num;
@@ -5,13 +5,22 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+// the most lines of input batch mode reads ahead
+#define MAX_BATCH_WINDOW 64
+
 canvas create_initial_canvas(int argc, char* argv[]);
 bool isValidFormat(const int num_args_needed, const int num_args_read,
 	bool should_be_last_value_on_line);
-void getValidCommand(const bool isLastElementOnLine, canvas* currentCanvas, canvas* savedCanvases, int* num_saved_canvases);
+void getValidCommand(const bool isLastElementOnLine, canvas* currentCanvas, canvas** savedCanvases, int* num_saved_canvases);
 char* getValidStr(const bool isLastElementOnLine);
 int getValidInt(const bool isLastElementOnLine);
 int getPosInt(const bool isLastElementOnLine);  
+FILE* command_input();
+void set_command_input(FILE* stream);
+void set_batch_window(int window);
+int coalesce_commands(char** lines, int numLines);
+bool next_batched_command();
+void free_batch();
 
 bool is_points_in_canvas(point firstPoint, point secondPoint, canvas currentCanvas);
 bool is_horizontal_line(point firstPoint, point secondPoint, canvas* currentCanvas);
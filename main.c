@@ -22,8 +22,9 @@ int main(int argc, char* argv[]) {
     canvas currentCanvas = create_initial_canvas(argc, argv); 
     print_canvas(currentCanvas); 
     while(1) {
-        printf("\nEnter your command: ");
-        getValidCommand(false, &currentCanvas, savedCanvases, &num_saved_canvases);
+        // the machine-readable output has no prompt, so every "@" header starts its own line
+        if (!is_diff_output()) printf("\nEnter your command: ");
+        getValidCommand(false, &currentCanvas, &savedCanvases, &num_saved_canvases);
     }
     return 0;
 }
@@ -0,0 +1,1004 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "segments.h"
+
+static unsigned long mark_clock = 0;
+
+// the buckets left to look through for segments, as up to two rectangles of buckets (columns rects[i][0] to rects[i][2], rows rects[i][1] to rects[i][3]),
+// each segment found being handed out once by stamping it with mark
+typedef struct bucket_walk_struct{
+    int rects[2][4];
+    int num_rects;
+    int rect;
+    int bx;
+    int by;
+    int entry;
+    unsigned long mark;
+} bucket_walk;
+
+/**
+ * Creates a new segment struct
+ * @param x : int representing the column of the first cell
+ * @param y : int representing the row (counted from the bottom) of the first cell
+ * @param dx : int representing the columns moved from one cell to the next (0 or 1)
+ * @param dy : int representing the rows moved from one cell to the next (-1, 0 or 1)
+ * @param length : int representing the number of cells
+ * @return the newly created segment struct, a whole line on its own
+ */
+segment create_segment(int x, int y, int dx, int dy, int length) {
+    segment line;
+    line.x = x;
+    line.y = y;
+    line.dx = dx;
+    line.dy = dy;
+    line.length = length;
+    line.prev_piece = -1;
+    line.next_piece = -1;
+    line.mark = 0;
+    return line;
+}
+
+/**
+ * Creates the segment for a line drawn between two cells, from its left end (its bottom end if it is vertical)
+ * @param x1 : int representing the column of one end
+ * @param y1 : int representing the row (counted from the bottom) of one end
+ * @param x2 : int representing the column of the other end
+ * @param y2 : int representing the row (counted from the bottom) of the other end
+ * @return the newly created segment struct (horizontal if both ends are the same cell)
+ */
+segment create_line_segment(int x1, int y1, int x2, int y2) {
+    bool firstStarts = x1 < x2 || (x1 == x2 && y1 <= y2);
+    int x = firstStarts ? x1 : x2;
+    int y = firstStarts ? y1 : y2;
+    int endX = firstStarts ? x2 : x1;
+    int endY = firstStarts ? y2 : y1;
+    int dx = (endY == y || endX > x) ? 1 : 0;
+    int dy = (endY > y) - (endY < y);
+    int length = ((endX - x > abs(endY - y)) ? endX - x : abs(endY - y)) + 1;
+    return create_segment(x, y, dx, dy, length);
+}
+
+/**
+ * Creates a new segment_edit struct
+ * @param command : char representing the change, 'a', 'd', 'r' or 'e'
+ * @param selection : char representing 'r' (row) or 'c' (column) for 'a' and 'd'
+ * @param x : int representing the column changed (or columns kept for 'r')
+ * @param y : int representing the row (counted from the bottom) changed (or rows kept for 'r')
+ * @return the newly created segment_edit struct
+ */
+segment_edit create_segment_edit(char command, char selection, int x, int y) {
+    segment_edit edit;
+    edit.command = command;
+    edit.selection = selection;
+    edit.x = x;
+    edit.y = y;
+    return edit;
+}
+
+/**
+ * Gets the character a segment draws on its cells
+ * @param line : segment struct representing the segment
+ * @return '-', '|', '/' or '\\'
+ */
+char segment_glyph(segment line) {
+    if (line.dy == 0) return '-';
+    if (line.dx == 0) return '|';
+    if (line.dy == 1) return '/';
+    return '\\';
+}
+
+/**
+ * Checks if a segment is drawn on a cell
+ * @param line : segment struct representing the segment
+ * @param x : int representing the column of the cell
+ * @param y : int representing the row (counted from the bottom) of the cell
+ * @return true if the cell is one of the segment's
+ */
+bool segment_covers(segment line, int x, int y) {
+    int i = (line.dx != 0) ? x - line.x : y - line.y;
+    return i >= 0 && i < line.length && x == line.x + i * line.dx && y == line.y + i * line.dy;
+}
+
+/**
+ * Orders segments by their first cell (bottom row first, then left to right), then direction and length
+ * @param first : pointer to the first segment struct
+ * @param second : pointer to the second segment struct
+ * @return negative, zero or positive as first comes before, with or after second
+ */
+static int compare_segments(const void* first, const void* second) {
+    const segment* a = (const segment*)first;
+    const segment* b = (const segment*)second;
+    if (a->y != b->y) return (a->y < b->y) ? -1 : 1;
+    if (a->x != b->x) return (a->x < b->x) ? -1 : 1;
+    if (a->dx != b->dx) return (a->dx < b->dx) ? -1 : 1;
+    if (a->dy != b->dy) return (a->dy < b->dy) ? -1 : 1;
+    if (a->length != b->length) return (a->length < b->length) ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Gets how many buckets it takes to cover a number of cells
+ * @param numCells : int representing the number of rows or columns
+ * @return the number of buckets across them
+ */
+static int buckets_for(int numCells) {
+    return (numCells + BUCKET_SIZE - 1) / BUCKET_SIZE;
+}
+
+/**
+ * Finds the first cell of a segment after cell i that is in a different bucket, so a segment's buckets are walked a bucket at a time
+ * @param line : segment struct representing the segment
+ * @param i : int representing the cell (counted from the first) to start from
+ * @return the cell counted from the first, or line.length if every cell left is in the same bucket as cell i
+ */
+static int next_bucket_cell(segment line, int i) {
+    int steps = line.length - i;
+    int x = line.x + i * line.dx;
+    int y = line.y + i * line.dy;
+    if (line.dx == 1 && BUCKET_SIZE - x % BUCKET_SIZE < steps) steps = BUCKET_SIZE - x % BUCKET_SIZE;
+    if (line.dy == 1 && BUCKET_SIZE - y % BUCKET_SIZE < steps) steps = BUCKET_SIZE - y % BUCKET_SIZE;
+    if (line.dy == -1 && y % BUCKET_SIZE + 1 < steps) steps = y % BUCKET_SIZE + 1;
+    return i + steps;
+}
+
+/**
+ * Counts the buckets a segment crosses
+ * @param line : segment struct representing the segment
+ * @return the number of buckets
+ */
+static int bucket_count(segment line) {
+    int count = 0;
+    for (int i = 0; i < line.length; i = next_bucket_cell(line, i)) count++;
+    return count;
+}
+
+/**
+ * Checks if two segments going the same way cross exactly the same buckets
+ * @param first : segment struct representing the first segment
+ * @param second : segment struct representing the second segment
+ * @return true if the buckets match
+ */
+static bool same_buckets(segment first, segment second) {
+    int i = 0;
+    int j = 0;
+    while (i < first.length && j < second.length) {
+        if ((first.x + i * first.dx) / BUCKET_SIZE != (second.x + j * second.dx) / BUCKET_SIZE
+            || (first.y + i * first.dy) / BUCKET_SIZE != (second.y + j * second.dy) / BUCKET_SIZE) return false;
+        i = next_bucket_cell(first, i);
+        j = next_bucket_cell(second, j);
+    }
+    return i >= first.length && j >= second.length;
+}
+
+/**
+ * Checks if one segment carries straight on from the end of another
+ * @param first : segment struct representing the segment that comes first
+ * @param second : segment struct representing the segment that may come right after it
+ * @return true if second starts on the cell after the last cell of first, going the same way
+ */
+static bool continues(segment first, segment second) {
+    return first.dx == second.dx && first.dy == second.dy
+        && second.x == first.x + first.length * first.dx && second.y == first.y + first.length * first.dy;
+}
+
+/**
+ * Creates a new segment_index struct holding no segments and no buckets
+ * @param none : none
+ * @return the newly created segment_index struct
+ */
+segment_index create_segment_index() {
+    segment_index index;
+    index.segments = NULL;
+    index.num_segments = 0;
+    index.segment_capacity = 0;
+    index.entries = NULL;
+    index.num_entries = 0;
+    index.entry_capacity = 0;
+    index.free_entry = -1;
+    index.num_free_entries = 0;
+    index.buckets = NULL;
+    index.bucket_rows = 0;
+    index.bucket_cols = 0;
+    return index;
+}
+
+/**
+ * Copies a segment index, including its buckets
+ * @param copy : pointer to segment_index struct to fill, holding nothing yet
+ * @param sourceIndex : pointer to segment_index struct representing the index to copy
+ * @return true if it was copied, false if there was not enough memory (copy holding nothing)
+ * @modifies copy
+ */
+bool copy_segment_index(segment_index* copy, segment_index* sourceIndex) {
+    *copy = *sourceIndex;
+    copy->segments = NULL;
+    copy->entries = NULL;
+    copy->buckets = NULL;
+    copy->bucket_rows = 0;
+    if (sourceIndex->segment_capacity > 0) copy->segments = (segment*)malloc(sourceIndex->segment_capacity * sizeof(segment));
+    if (sourceIndex->entry_capacity > 0) copy->entries = (bucket_entry*)malloc(sourceIndex->entry_capacity * sizeof(bucket_entry));
+    if (sourceIndex->bucket_rows > 0) copy->buckets = (int**)calloc(sourceIndex->bucket_rows, sizeof(int*));
+    bool copied = (sourceIndex->segment_capacity == 0 || copy->segments != NULL)
+        && (sourceIndex->entry_capacity == 0 || copy->entries != NULL)
+        && (sourceIndex->bucket_rows == 0 || copy->buckets != NULL);
+    if (copied) copy->bucket_rows = sourceIndex->bucket_rows;
+    for (int by = 0; copied && by < sourceIndex->bucket_rows && sourceIndex->bucket_cols > 0; by++) {
+        copy->buckets[by] = (int*)malloc(sourceIndex->bucket_cols * sizeof(int));
+        if (copy->buckets[by] == NULL) copied = false;
+        else memcpy(copy->buckets[by], sourceIndex->buckets[by], sourceIndex->bucket_cols * sizeof(int));
+    }
+    if (!copied) {
+        free_segment_index(copy);
+        *copy = create_segment_index();
+        return false;
+    }
+    if (sourceIndex->num_segments > 0) memcpy(copy->segments, sourceIndex->segments, sourceIndex->num_segments * sizeof(segment));
+    if (sourceIndex->num_entries > 0) memcpy(copy->entries, sourceIndex->entries, sourceIndex->num_entries * sizeof(bucket_entry));
+    return true;
+}
+
+/**
+ * Frees all memory allocated for the members of a segment_index struct
+ * @param index : pointer to segment_index struct representing the index to free
+ * @return nothing
+ * @modifies frees memory from index
+ */
+void free_segment_index(segment_index* index) {
+    for (int by = 0; by < index->bucket_rows; by++) {
+        free(index->buckets[by]);
+    }
+    free(index->buckets);
+    free(index->entries);
+    free(index->segments);
+}
+
+/**
+ * Changes the grid of buckets of a segment index to cover a number of rows and columns
+ * Buckets taken away must already be empty
+ * @param index : pointer to segment_index struct representing the index
+ * @param numRows : int representing the number of rows to cover
+ * @param numCols : int representing the number of columns to cover
+ * @return true if the grid was changed, false if there was not enough memory (the buckets left as they were)
+ * @modifies index
+ */
+bool resize_bucket_grid(segment_index* index, int numRows, int numCols) {
+    int bucketRows = buckets_for(numRows);
+    int bucketCols = buckets_for(numCols);
+    int keptRows = (bucketRows < index->bucket_rows) ? bucketRows : index->bucket_rows;
+    // everything that allocates comes first, so running out of memory leaves every bucket as it was
+    if (bucketCols > index->bucket_cols) {
+        for (int by = 0; by < keptRows; by++) {
+            int* bucketRow = (int*)realloc(index->buckets[by], bucketCols * sizeof(int));
+            if (bucketRow == NULL) return false;
+            index->buckets[by] = bucketRow;
+        }
+    }
+    if (bucketRows > index->bucket_rows) {
+        int** buckets = (int**)realloc(index->buckets, bucketRows * sizeof(int*));
+        if (buckets == NULL) return false;
+        index->buckets = buckets;
+        for (int by = index->bucket_rows; by < bucketRows; by++) {
+            index->buckets[by] = (bucketCols > 0) ? (int*)malloc(bucketCols * sizeof(int)) : NULL;
+            if (bucketCols > 0 && index->buckets[by] == NULL) {
+                for (int added = index->bucket_rows; added < by; added++) free(index->buckets[added]);
+                return false;
+            }
+        }
+    }
+    for (int by = 0; by < bucketRows; by++) {
+        int firstNew = (by < index->bucket_rows) ? index->bucket_cols : 0;
+        for (int bx = firstNew; bx < bucketCols; bx++) index->buckets[by][bx] = -1;
+    }
+    for (int by = bucketRows; by < index->bucket_rows; by++) {
+        free(index->buckets[by]);
+    }
+    // memory that cannot be given back is kept
+    if (bucketRows == 0) {
+        free(index->buckets);
+        index->buckets = NULL;
+    }
+    else if (bucketRows < index->bucket_rows) {
+        int** buckets = (int**)realloc(index->buckets, bucketRows * sizeof(int*));
+        if (buckets != NULL) index->buckets = buckets;
+    }
+    if (bucketCols > 0 && bucketCols < index->bucket_cols) {
+        for (int by = 0; by < keptRows; by++) {
+            int* bucketRow = (int*)realloc(index->buckets[by], bucketCols * sizeof(int));
+            if (bucketRow != NULL) index->buckets[by] = bucketRow;
+        }
+    }
+    index->bucket_rows = bucketRows;
+    index->bucket_cols = bucketCols;
+    return true;
+}
+
+/**
+ * Works out the bytes a segment index uses on a canvas of a given size
+ * @param index : pointer to segment_index struct representing the index
+ * @param numRows : int representing the number of rows of the canvas
+ * @param numCols : int representing the number of columns of the canvas
+ * @return the number of bytes
+ */
+size_t segment_index_footprint(segment_index* index, int numRows, int numCols) {
+    size_t bucketRows = buckets_for(numRows);
+    return index->segment_capacity * sizeof(segment) + index->entry_capacity * sizeof(bucket_entry)
+        + bucketRows * sizeof(int*) + bucketRows * buckets_for(numCols) * sizeof(int);
+}
+
+/**
+ * Gets the capacity an array needs to grow to, doubling it so growing one at a time takes constant time on average
+ * @param capacity : int representing the capacity now
+ * @param needed : int representing the number of elements the array must hold
+ * @return the capacity to grow to (capacity if it is already enough)
+ */
+static int grown_capacity(int capacity, int needed) {
+    if (needed <= capacity) return capacity;
+    return (capacity * 2 > needed) ? capacity * 2 : needed;
+}
+
+/**
+ * Works out the bytes a segment index allocates to make room for more segments and bucket entries
+ * @param index : pointer to segment_index struct representing the index
+ * @param extraSegments : int representing the number of segments to add
+ * @param extraEntries : int representing the number of bucket entries to add
+ * @return the number of bytes
+ */
+static size_t growth_footprint(segment_index* index, int extraSegments, int extraEntries) {
+    int segmentCapacity = grown_capacity(index->segment_capacity, index->num_segments + extraSegments);
+    int entryCapacity = grown_capacity(index->entry_capacity, index->num_entries - index->num_free_entries + extraEntries);
+    return (size_t)(segmentCapacity - index->segment_capacity) * sizeof(segment)
+        + (size_t)(entryCapacity - index->entry_capacity) * sizeof(bucket_entry);
+}
+
+/**
+ * Makes room in a segment index for more segments and bucket entries
+ * @param index : pointer to segment_index struct representing the index
+ * @param extraSegments : int representing the number of segments to add
+ * @param extraEntries : int representing the number of bucket entries to add
+ * @return true if there is room, false if there was not enough memory (the segments and buckets left as they were)
+ * @modifies index
+ */
+static bool reserve_segments(segment_index* index, int extraSegments, int extraEntries) {
+    int segmentCapacity = grown_capacity(index->segment_capacity, index->num_segments + extraSegments);
+    int entryCapacity = grown_capacity(index->entry_capacity, index->num_entries - index->num_free_entries + extraEntries);
+    if (segmentCapacity > index->segment_capacity) {
+        segment* segments = (segment*)realloc(index->segments, segmentCapacity * sizeof(segment));
+        if (segments == NULL) return false;
+        index->segments = segments;
+        index->segment_capacity = segmentCapacity;
+    }
+    if (entryCapacity > index->entry_capacity) {
+        bucket_entry* entries = (bucket_entry*)realloc(index->entries, entryCapacity * sizeof(bucket_entry));
+        if (entries == NULL) return false;
+        index->entries = entries;
+        index->entry_capacity = entryCapacity;
+    }
+    return true;
+}
+
+/**
+ * Lists a segment in every bucket it crosses, using entries room was already made for
+ * @param index : pointer to segment_index struct representing the index
+ * @param id : int representing the segment's place in segments
+ * @return nothing
+ * @modifies index
+ */
+static void register_segment(segment_index* index, int id) {
+    segment line = index->segments[id];
+    for (int i = 0; i < line.length; i = next_bucket_cell(line, i)) {
+        int bx = (line.x + i * line.dx) / BUCKET_SIZE;
+        int by = (line.y + i * line.dy) / BUCKET_SIZE;
+        int entry;
+        if (index->free_entry != -1) {
+            entry = index->free_entry;
+            index->free_entry = index->entries[entry].next;
+            index->num_free_entries--;
+        }
+        else entry = index->num_entries++;
+        index->entries[entry].segment = id;
+        index->entries[entry].next = index->buckets[by][bx];
+        index->buckets[by][bx] = entry;
+    }
+}
+
+/**
+ * Takes a segment out of every bucket it crosses, keeping the entries for later
+ * @param index : pointer to segment_index struct representing the index
+ * @param id : int representing the segment's place in segments
+ * @return nothing
+ * @modifies index
+ */
+static void unregister_segment(segment_index* index, int id) {
+    segment line = index->segments[id];
+    for (int i = 0; i < line.length; i = next_bucket_cell(line, i)) {
+        int* link = &index->buckets[(line.y + i * line.dy) / BUCKET_SIZE][(line.x + i * line.dx) / BUCKET_SIZE];
+        while (*link != -1 && index->entries[*link].segment != id) link = &index->entries[*link].next;
+        if (*link == -1) continue;
+        int entry = *link;
+        *link = index->entries[entry].next;
+        index->entries[entry].next = index->free_entry;
+        index->free_entry = entry;
+        index->num_free_entries++;
+    }
+}
+
+/**
+ * Takes a segment out of a segment index, moving the last segment into its place
+ * @param index : pointer to segment_index struct representing the index
+ * @param id : int representing the segment's place in segments
+ * @return nothing
+ * @modifies index
+ */
+static void remove_segment(segment_index* index, int id) {
+    segment line = index->segments[id];
+    unregister_segment(index, id);
+    index->segments[line.prev_piece].next_piece = line.next_piece;
+    index->segments[line.next_piece].prev_piece = line.prev_piece;
+    int last = index->num_segments - 1;
+    index->num_segments--;
+    if (id == last) return;
+    segment moved = index->segments[last];
+    for (int i = 0; i < moved.length; i = next_bucket_cell(moved, i)) {
+        int entry = index->buckets[(moved.y + i * moved.dy) / BUCKET_SIZE][(moved.x + i * moved.dx) / BUCKET_SIZE];
+        while (entry != -1 && index->entries[entry].segment != last) entry = index->entries[entry].next;
+        if (entry != -1) index->entries[entry].segment = id;
+    }
+    index->segments[id] = moved;
+    if (moved.next_piece == last) {
+        index->segments[id].prev_piece = id;
+        index->segments[id].next_piece = id;
+    }
+    else {
+        index->segments[moved.prev_piece].next_piece = id;
+        index->segments[moved.next_piece].prev_piece = id;
+    }
+}
+
+/**
+ * Adds a segment to a segment index as the next piece after another piece of the same line, using room already made for it
+ * @param index : pointer to segment_index struct representing the index
+ * @param line : segment struct representing the piece
+ * @param after : int representing the place in segments of the piece it comes after, or -1 if it is a whole line
+ * @return the piece's place in segments
+ * @modifies index
+ */
+static int append_segment(segment_index* index, segment line, int after) {
+    int id = index->num_segments++;
+    line.mark = 0;
+    if (after == -1) {
+        line.prev_piece = id;
+        line.next_piece = id;
+    }
+    else {
+        line.prev_piece = after;
+        line.next_piece = index->segments[after].next_piece;
+        index->segments[line.next_piece].prev_piece = id;
+        index->segments[after].next_piece = id;
+    }
+    index->segments[id] = line;
+    register_segment(index, id);
+    return id;
+}
+
+/**
+ * Works out the bytes a segment index allocates to add a line
+ * @param index : pointer to segment_index struct representing the index
+ * @param line : segment struct representing the line
+ * @return the number of bytes
+ */
+size_t add_segment_footprint(segment_index* index, segment line) {
+    return growth_footprint(index, 1, bucket_count(line));
+}
+
+/**
+ * Makes room in a segment index for a line to be added with add_segment
+ * @param index : pointer to segment_index struct representing the index
+ * @param line : segment struct representing the line
+ * @return true if there is room, false if there was not enough memory (nothing changed)
+ * @modifies index
+ */
+bool make_room_for_segment(segment_index* index, segment line) {
+    return reserve_segments(index, 1, bucket_count(line));
+}
+
+/**
+ * Adds a line to a segment index, unless a whole line on exactly the same cells is already there
+ * Room must have been made for it with make_room_for_segment
+ * @param index : pointer to segment_index struct representing the index
+ * @param line : segment struct representing the line
+ * @return nothing
+ * @modifies index
+ */
+void add_segment(segment_index* index, segment line) {
+    // drawing the same line again changes nothing, so it is not listed twice
+    for (int entry = index->buckets[line.y / BUCKET_SIZE][line.x / BUCKET_SIZE]; entry != -1; entry = index->entries[entry].next) {
+        segment other = index->segments[index->entries[entry].segment];
+        if (other.next_piece == index->entries[entry].segment && other.x == line.x && other.y == line.y
+            && other.dx == line.dx && other.dy == line.dy && other.length == line.length) return;
+    }
+    append_segment(index, line, -1);
+}
+
+/**
+ * Starts a walk through rectangles of buckets added to it with add_walk_rect
+ * @param none : none
+ * @return the newly created bucket_walk struct, with a mark no segment holds yet
+ */
+static bucket_walk create_walk() {
+    bucket_walk walk;
+    walk.num_rects = 0;
+    walk.rect = 0;
+    walk.bx = 0;
+    walk.by = 0;
+    walk.entry = -1;
+    mark_clock++;
+    walk.mark = mark_clock;
+    return walk;
+}
+
+/**
+ * Adds a rectangle of buckets to a walk, cut down to the buckets the index has
+ * @param index : pointer to segment_index struct representing the index walked
+ * @param walk : pointer to bucket_walk struct representing the walk
+ * @param bxLow : int representing the leftmost bucket column
+ * @param byLow : int representing the bottom bucket row
+ * @param bxHigh : int representing the rightmost bucket column
+ * @param byHigh : int representing the top bucket row
+ * @return nothing
+ * @modifies walk
+ */
+static void add_walk_rect(segment_index* index, bucket_walk* walk, int bxLow, int byLow, int bxHigh, int byHigh) {
+    int* rect = walk->rects[walk->num_rects++];
+    rect[0] = (bxLow < 0) ? 0 : bxLow;
+    rect[1] = (byLow < 0) ? 0 : byLow;
+    rect[2] = (bxHigh >= index->bucket_cols) ? index->bucket_cols - 1 : bxHigh;
+    rect[3] = (byHigh >= index->bucket_rows) ? index->bucket_rows - 1 : byHigh;
+    if (walk->num_rects == 1) {
+        walk->bx = rect[0] - 1;
+        walk->by = rect[1];
+    }
+}
+
+/**
+ * Hands out the next segment of a walk, each segment in its buckets once
+ * The index must not change while it is walked
+ * @param index : pointer to segment_index struct representing the index walked
+ * @param walk : pointer to bucket_walk struct representing the walk
+ * @return the place in segments of the segment, or -1 once every bucket has been looked through
+ * @modifies walk and the marks of the segments handed out
+ */
+static int next_walk_segment(segment_index* index, bucket_walk* walk) {
+    while (true) {
+        while (walk->entry != -1) {
+            int id = index->entries[walk->entry].segment;
+            walk->entry = index->entries[walk->entry].next;
+            if (index->segments[id].mark != walk->mark) {
+                index->segments[id].mark = walk->mark;
+                return id;
+            }
+        }
+        if (walk->rect >= walk->num_rects) return -1;
+        int* rect = walk->rects[walk->rect];
+        walk->bx++;
+        if (walk->bx > rect[2]) {
+            walk->bx = rect[0];
+            walk->by++;
+        }
+        if (walk->by > rect[3] || rect[0] > rect[2]) {
+            walk->rect++;
+            if (walk->rect < walk->num_rects) {
+                walk->bx = walk->rects[walk->rect][0] - 1;
+                walk->by = walk->rects[walk->rect][1];
+            }
+            continue;
+        }
+        walk->entry = index->buckets[walk->by][walk->bx];
+    }
+}
+
+/**
+ * Starts a walk through the buckets holding every segment a change can affect: those from the row or column changed onwards
+ * @param index : pointer to segment_index struct representing the index walked
+ * @param edit : segment_edit struct representing the change
+ * @return the newly created bucket_walk struct
+ */
+static bucket_walk edit_walk(segment_index* index, segment_edit edit) {
+    bucket_walk walk = create_walk();
+    if (edit.command == 'e') add_walk_rect(index, &walk, edit.x / BUCKET_SIZE, edit.y / BUCKET_SIZE, edit.x / BUCKET_SIZE, edit.y / BUCKET_SIZE);
+    else if (edit.command == 'r') {
+        add_walk_rect(index, &walk, 0, edit.y / BUCKET_SIZE, index->bucket_cols, index->bucket_rows);
+        add_walk_rect(index, &walk, edit.x / BUCKET_SIZE, 0, index->bucket_cols, edit.y / BUCKET_SIZE - 1);
+    }
+    else if (edit.selection == 'r') add_walk_rect(index, &walk, 0, edit.y / BUCKET_SIZE, index->bucket_cols, index->bucket_rows);
+    else add_walk_rect(index, &walk, edit.x / BUCKET_SIZE, 0, index->bucket_cols, index->bucket_rows);
+    return walk;
+}
+
+/**
+ * Finds the cells of a segment whose row (or column) is below a position, which are always a run at one end of it
+ * @param start : int representing the row (or column) of the first cell
+ * @param step : int representing how much the row (or column) changes from one cell to the next
+ * @param length : int representing the number of cells
+ * @param pos : int representing the position
+ * @param from : pointer to int to set to the first cell of the run
+ * @param to : pointer to int to set to one past the last cell of the run
+ * @return nothing
+ * @modifies from and to
+ */
+static void cells_below(int start, int step, int length, int pos, int* from, int* to) {
+    *from = 0;
+    *to = length;
+    if (step == 0 && start >= pos) *to = 0;
+    else if (step == 1) *to = (pos - start < 0) ? 0 : (pos - start > length) ? length : pos - start;
+    else if (step == -1) *from = (start - pos + 1 < 0) ? 0 : (start - pos + 1 > length) ? length : start - pos + 1;
+}
+
+/**
+ * Finds the cells of a segment whose row (or column) is at or above a position, the cells cells_below leaves out
+ * @param start : int representing the row (or column) of the first cell
+ * @param step : int representing how much the row (or column) changes from one cell to the next
+ * @param length : int representing the number of cells
+ * @param pos : int representing the position
+ * @param from : pointer to int to set to the first cell of the run
+ * @param to : pointer to int to set to one past the last cell of the run
+ * @return nothing
+ * @modifies from and to
+ */
+static void cells_from(int start, int step, int length, int pos, int* from, int* to) {
+    int belowFrom;
+    int belowTo;
+    cells_below(start, step, length, pos, &belowFrom, &belowTo);
+    *from = (belowFrom == 0) ? belowTo : 0;
+    *to = (belowFrom == 0) ? length : belowFrom;
+}
+
+/**
+ * Adds cells from to to - 1 of a segment, moved by (shiftX, shiftY), to the pieces a change leaves of it, joining it onto the last piece if they meet
+ * @param pieces : array of segment structs representing the pieces so far
+ * @param numPieces : int representing the number of pieces so far
+ * @param line : segment struct representing the segment
+ * @param from : int representing the first cell
+ * @param to : int representing one past the last cell
+ * @param shiftX : int representing the columns the cells move
+ * @param shiftY : int representing the rows the cells move
+ * @return the number of pieces now
+ * @modifies pieces
+ */
+static int add_piece(segment pieces[2], int numPieces, segment line, int from, int to, int shiftX, int shiftY) {
+    if (from >= to) return numPieces;
+    segment piece = line;
+    piece.x = line.x + from * line.dx + shiftX;
+    piece.y = line.y + from * line.dy + shiftY;
+    piece.length = to - from;
+    if (numPieces > 0 && continues(pieces[numPieces - 1], piece)) {
+        pieces[numPieces - 1].length += piece.length;
+        return numPieces;
+    }
+    pieces[numPieces] = piece;
+    return numPieces + 1;
+}
+
+/**
+ * Works out what is left of a segment after a change, in order along the segment
+ * @param line : segment struct representing the segment
+ * @param edit : segment_edit struct representing the change
+ * @param pieces : array of segment structs to fill with the pieces left (keeping the links and mark of line)
+ * @return the number of pieces left, 0 to 2
+ * @modifies pieces
+ */
+static int edit_pieces(segment line, segment_edit edit, segment pieces[2]) {
+    if (edit.command == 'e') {
+        if (!segment_covers(line, edit.x, edit.y)) return add_piece(pieces, 0, line, 0, line.length, 0, 0);
+        int i = (line.dx != 0) ? edit.x - line.x : edit.y - line.y;
+        return add_piece(pieces, add_piece(pieces, 0, line, 0, i, 0, 0), line, i + 1, line.length, 0, 0);
+    }
+    if (edit.command == 'r') {
+        int xFrom, xTo, yFrom, yTo;
+        cells_below(line.x, line.dx, line.length, edit.x, &xFrom, &xTo);
+        cells_below(line.y, line.dy, line.length, edit.y, &yFrom, &yTo);
+        return add_piece(pieces, 0, line, (xFrom > yFrom) ? xFrom : yFrom, (xTo < yTo) ? xTo : yTo, 0, 0);
+    }
+    bool isRow = edit.selection == 'r';
+    int start = isRow ? line.y : line.x;
+    int step = isRow ? line.dy : line.dx;
+    int pos = isRow ? edit.y : edit.x;
+    int shift = (edit.command == 'a') ? 1 : -1;
+    int belowFrom, belowTo, movedFrom, movedTo;
+    // cells before the row or column stay put, the rest move (a deleted row or column's cells going with it)
+    cells_below(start, step, line.length, pos, &belowFrom, &belowTo);
+    cells_from(start, step, line.length, (edit.command == 'a') ? pos : pos + 1, &movedFrom, &movedTo);
+    int numPieces = 0;
+    if (belowFrom <= movedFrom) numPieces = add_piece(pieces, numPieces, line, belowFrom, belowTo, 0, 0);
+    numPieces = add_piece(pieces, numPieces, line, movedFrom, movedTo, isRow ? 0 : shift, isRow ? shift : 0);
+    if (belowFrom > movedFrom) numPieces = add_piece(pieces, numPieces, line, belowFrom, belowTo, 0, 0);
+    return numPieces;
+}
+
+/**
+ * Counts what a change adds to a segment index for one segment
+ * @param line : segment struct representing the segment
+ * @param edit : segment_edit struct representing the change
+ * @param extraSegments : pointer to int to add the segments added to
+ * @param extraEntries : pointer to int to add the bucket entries added to
+ * @return nothing
+ * @modifies extraSegments and extraEntries
+ */
+static void count_edit_growth(segment line, segment_edit edit, int* extraSegments, int* extraEntries) {
+    segment pieces[2];
+    int numPieces = edit_pieces(line, edit, pieces);
+    if (numPieces == 0 || (numPieces == 1 && same_buckets(line, pieces[0]))) return;
+    int entries = 0;
+    for (int p = 0; p < numPieces; p++) entries += bucket_count(pieces[p]);
+    *extraSegments += numPieces - 1;
+    if (entries > bucket_count(line)) *extraEntries += entries - bucket_count(line);
+}
+
+/**
+ * Works out the bytes a segment index allocates to make a change with edit_segments
+ * @param index : pointer to segment_index struct representing the index
+ * @param edit : segment_edit struct representing the change
+ * @param numRows : int representing the number of rows of the canvas after the change
+ * @param numCols : int representing the number of columns of the canvas after the change
+ * @return the number of bytes
+ */
+size_t edit_segments_footprint(segment_index* index, segment_edit edit, int numRows, int numCols) {
+    int extraSegments = 0;
+    int extraEntries = 0;
+    bucket_walk walk = edit_walk(index, edit);
+    for (int id = next_walk_segment(index, &walk); id != -1; id = next_walk_segment(index, &walk)) {
+        count_edit_growth(index->segments[id], edit, &extraSegments, &extraEntries);
+    }
+    size_t bucketRows = buckets_for(numRows);
+    size_t bucketBytes = bucketRows * sizeof(int*) + bucketRows * buckets_for(numCols) * sizeof(int);
+    size_t oldBucketBytes = index->bucket_rows * sizeof(int*) + (size_t)index->bucket_rows * index->bucket_cols * sizeof(int);
+    return growth_footprint(index, extraSegments, extraEntries) + ((bucketBytes > oldBucketBytes) ? bucketBytes - oldBucketBytes : 0);
+}
+
+/**
+ * Joins a piece of a line with any other piece of the same line that carries straight on from it, as deleting a row or column can close the gap between them
+ * Pieces still holding pending as their mark are left alone
+ * @param index : pointer to segment_index struct representing the index
+ * @param id : int representing the piece's place in segments
+ * @param pending : unsigned long representing the mark of pieces not yet changed
+ * @return the piece's place in segments, which may have moved
+ * @modifies index
+ */
+static int join_pieces(segment_index* index, int id, unsigned long pending) {
+    int other = index->segments[id].next_piece;
+    while (other != id) {
+        segment line = index->segments[id];
+        segment piece = index->segments[other];
+        bool after = continues(line, piece);
+        if (piece.mark == pending || (!after && !continues(piece, line))) {
+            other = piece.next_piece;
+            continue;
+        }
+        // the entries freed by both pieces are enough for the joined one
+        unregister_segment(index, id);
+        if (!after) {
+            index->segments[id].x = piece.x;
+            index->segments[id].y = piece.y;
+        }
+        index->segments[id].length += piece.length;
+        bool moved = index->num_segments - 1 == id;
+        remove_segment(index, other);
+        if (moved) id = other;
+        register_segment(index, id);
+        other = index->segments[id].next_piece;
+    }
+    return id;
+}
+
+/**
+ * Orders places in segments from last to first
+ * @param first : pointer to the first int
+ * @param second : pointer to the second int
+ * @return negative, zero or positive as first comes before, with or after second
+ */
+static int compare_descending(const void* first, const void* second) {
+    return *(const int*)second - *(const int*)first;
+}
+
+/**
+ * Changes the segments of a segment index to match a change to the canvas's cells, and the buckets to the canvas's new size
+ * Only segments in buckets from the changed row or column onwards are looked at
+ * @param index : pointer to segment_index struct representing the index
+ * @param edit : segment_edit struct representing the change
+ * @param numRows : int representing the number of rows of the canvas after the change
+ * @param numCols : int representing the number of columns of the canvas after the change
+ * @return true if the index was changed, false if there was not enough memory (nothing changed)
+ * @modifies index
+ */
+bool edit_segments(segment_index* index, segment_edit edit, int numRows, int numCols) {
+    int oldRows = index->bucket_rows * BUCKET_SIZE;
+    int oldCols = index->bucket_cols * BUCKET_SIZE;
+    int keptRows = (oldRows > numRows) ? oldRows : numRows;
+    int keptCols = (oldCols > numCols) ? oldCols : numCols;
+    // the buckets cover the canvas before and after the change until every segment has moved
+    if (!resize_bucket_grid(index, keptRows, keptCols)) return false;
+    int numIds = 0;
+    int extraSegments = 0;
+    int extraEntries = 0;
+    bucket_walk walk = edit_walk(index, edit);
+    for (int id = next_walk_segment(index, &walk); id != -1; id = next_walk_segment(index, &walk)) {
+        count_edit_growth(index->segments[id], edit, &extraSegments, &extraEntries);
+        numIds++;
+    }
+    int* ids = (int*)malloc((numIds + 1) * sizeof(int));
+    if (ids == NULL || !reserve_segments(index, extraSegments, extraEntries)) {
+        free(ids);
+        resize_bucket_grid(index, oldRows, oldCols);
+        return false;
+    }
+    walk = edit_walk(index, edit);
+    numIds = 0;
+    for (int id = next_walk_segment(index, &walk); id != -1; id = next_walk_segment(index, &walk)) ids[numIds++] = id;
+    // segments are only ever moved down from the end, so going from last to first never moves one still to be changed
+    qsort(ids, numIds, sizeof(int), compare_descending);
+    for (int k = 0; k < numIds; k++) {
+        int id = ids[k];
+        segment line = index->segments[id];
+        segment pieces[2];
+        int numPieces = edit_pieces(line, edit, pieces);
+        index->segments[id].mark = 0;
+        if (numPieces == 0) {
+            remove_segment(index, id);
+            continue;
+        }
+        bool rebucket = numPieces > 1 || !same_buckets(line, pieces[0]);
+        if (rebucket) unregister_segment(index, id);
+        index->segments[id].x = pieces[0].x;
+        index->segments[id].y = pieces[0].y;
+        index->segments[id].length = pieces[0].length;
+        if (rebucket) register_segment(index, id);
+        if (numPieces > 1) append_segment(index, pieces[1], id);
+        // a piece split in two by a delete is a diagonal, whose pieces cannot meet another piece of the line, so only whole pieces are joined
+        else if (edit.command == 'd') join_pieces(index, id, walk.mark);
+    }
+    free(ids);
+    resize_bucket_grid(index, numRows, numCols);
+    return true;
+}
+
+/**
+ * Checks if any cell of a segment is inside a rectangle of cells
+ * @param line : segment struct representing the segment
+ * @param xLow : int representing the leftmost column of the rectangle
+ * @param yLow : int representing the bottom row of the rectangle
+ * @param xHigh : int representing the rightmost column of the rectangle
+ * @param yHigh : int representing the top row of the rectangle
+ * @return true if a cell is inside
+ */
+static bool segment_crosses(segment line, int xLow, int yLow, int xHigh, int yHigh) {
+    int xFrom, xTo, yFrom, yTo, lowFrom, lowTo;
+    cells_below(line.x, line.dx, line.length, xHigh + 1, &xFrom, &xTo);
+    cells_below(line.y, line.dy, line.length, yHigh + 1, &yFrom, &yTo);
+    int from = (xFrom > yFrom) ? xFrom : yFrom;
+    int to = (xTo < yTo) ? xTo : yTo;
+    cells_from(line.x, line.dx, line.length, xLow, &lowFrom, &lowTo);
+    if (lowFrom > from) from = lowFrom;
+    if (lowTo < to) to = lowTo;
+    cells_from(line.y, line.dy, line.length, yLow, &lowFrom, &lowTo);
+    if (lowFrom > from) from = lowFrom;
+    if (lowTo < to) to = lowTo;
+    return from < to;
+}
+
+/**
+ * Finds every segment with a cell inside a rectangle of cells, looking only in the buckets under the rectangle
+ * @param index : pointer to segment_index struct representing the index
+ * @param xLow : int representing the leftmost column of the rectangle
+ * @param yLow : int representing the bottom row of the rectangle
+ * @param xHigh : int representing the rightmost column of the rectangle
+ * @param yHigh : int representing the top row of the rectangle
+ * @param found : pointer to set to a copy of the segments found in order (see compare_segments), allocated with malloc
+ * @return the number of segments found, or -1 if there was not enough memory (found left unset)
+ * @modifies found
+ */
+int find_segments(segment_index* index, int xLow, int yLow, int xHigh, int yHigh, segment** found) {
+    int numFound = 0;
+    bucket_walk walk = create_walk();
+    add_walk_rect(index, &walk, xLow / BUCKET_SIZE, yLow / BUCKET_SIZE, xHigh / BUCKET_SIZE, yHigh / BUCKET_SIZE);
+    for (int id = next_walk_segment(index, &walk); id != -1; id = next_walk_segment(index, &walk)) {
+        if (segment_crosses(index->segments[id], xLow, yLow, xHigh, yHigh)) numFound++;
+    }
+    *found = (segment*)malloc((numFound + 1) * sizeof(segment));
+    if (*found == NULL) return -1;
+    numFound = 0;
+    walk = create_walk();
+    add_walk_rect(index, &walk, xLow / BUCKET_SIZE, yLow / BUCKET_SIZE, xHigh / BUCKET_SIZE, yHigh / BUCKET_SIZE);
+    for (int id = next_walk_segment(index, &walk); id != -1; id = next_walk_segment(index, &walk)) {
+        if (segment_crosses(index->segments[id], xLow, yLow, xHigh, yHigh)) (*found)[numFound++] = index->segments[id];
+    }
+    qsort(*found, numFound, sizeof(segment), compare_segments);
+    return numFound;
+}
+
+/**
+ * Finds a segment drawn on a cell
+ * @param index : pointer to segment_index struct representing the index
+ * @param x : int representing the column of the cell
+ * @param y : int representing the row (counted from the bottom) of the cell
+ * @return the segment's place in segments, or -1 if there is none
+ */
+static int covering_segment(segment_index* index, int x, int y) {
+    if (x / BUCKET_SIZE >= index->bucket_cols || y / BUCKET_SIZE >= index->bucket_rows) return -1;
+    for (int entry = index->buckets[y / BUCKET_SIZE][x / BUCKET_SIZE]; entry != -1; entry = index->entries[entry].next) {
+        if (segment_covers(index->segments[index->entries[entry].segment], x, y)) return index->entries[entry].segment;
+    }
+    return -1;
+}
+
+/**
+ * Finds every piece of every line drawn on a cell
+ * @param index : pointer to segment_index struct representing the index
+ * @param x : int representing the column of the cell
+ * @param y : int representing the row (counted from the bottom) of the cell
+ * @param pieces : pointer to set to a copy of the pieces found, allocated with malloc
+ * @return the number of pieces found, or -1 if there was not enough memory (pieces left unset)
+ * @modifies pieces
+ */
+int find_lines(segment_index* index, int x, int y, segment** pieces) {
+    int numPieces = 0;
+    bucket_walk walk = create_walk();
+    add_walk_rect(index, &walk, x / BUCKET_SIZE, y / BUCKET_SIZE, x / BUCKET_SIZE, y / BUCKET_SIZE);
+    for (int id = next_walk_segment(index, &walk); id != -1; id = next_walk_segment(index, &walk)) {
+        if (!segment_covers(index->segments[id], x, y)) continue;
+        for (int piece = index->segments[id].next_piece; piece != id; piece = index->segments[piece].next_piece) numPieces++;
+        numPieces++;
+    }
+    *pieces = (segment*)malloc((numPieces + 1) * sizeof(segment));
+    if (*pieces == NULL) return -1;
+    numPieces = 0;
+    for (int entry = index->buckets[y / BUCKET_SIZE][x / BUCKET_SIZE]; entry != -1; entry = index->entries[entry].next) {
+        int id = index->entries[entry].segment;
+        if (!segment_covers(index->segments[id], x, y)) continue;
+        int piece = id;
+        do {
+            (*pieces)[numPieces++] = index->segments[piece];
+            piece = index->segments[piece].next_piece;
+        } while (piece != id);
+    }
+    return numPieces;
+}
+
+/**
+ * Takes every piece of every line drawn on a cell out of a segment index, without allocating
+ * @param index : pointer to segment_index struct representing the index
+ * @param x : int representing the column of the cell
+ * @param y : int representing the row (counted from the bottom) of the cell
+ * @return nothing
+ * @modifies index
+ */
+void remove_lines(segment_index* index, int x, int y) {
+    for (int id = covering_segment(index, x, y); id != -1; id = covering_segment(index, x, y)) {
+        while (index->segments[id].next_piece != id) {
+            int piece = index->segments[id].next_piece;
+            bool moved = index->num_segments - 1 == id;
+            remove_segment(index, piece);
+            if (moved) id = piece;
+        }
+        remove_segment(index, id);
+    }
+}
+
+/**
+ * Works out what the segments of a segment index draw on a cell: a line's character, '+' where different lines cross, or BACKGROUND
+ * @param index : pointer to segment_index struct representing the index
+ * @param x : int representing the column of the cell
+ * @param y : int representing the row (counted from the bottom) of the cell
+ * @return the character
+ */
+char glyph_at(segment_index* index, int x, int y) {
+    char glyph = '\0';
+    if (x / BUCKET_SIZE >= index->bucket_cols || y / BUCKET_SIZE >= index->bucket_rows) return glyph;
+    for (int entry = index->buckets[y / BUCKET_SIZE][x / BUCKET_SIZE]; entry != -1; entry = index->entries[entry].next) {
+        segment line = index->segments[index->entries[entry].segment];
+        if (!segment_covers(line, x, y)) continue;
+        if (glyph == '\0') glyph = segment_glyph(line);
+        else if (glyph != segment_glyph(line)) glyph = '+';
+    }
+    return glyph;
+}
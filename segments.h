@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+// width and height in cells of the squares a segment index is divided into
+#define BUCKET_SIZE 16
+
+// a straight run of cells drawn by one line: length cells from (x, y) (row counted from the bottom), each dx columns and dy rows on from the last
+// (dx, dy) is (1, 0) for '-', (0, 1) for '|', (1, 1) for '/' and (1, -1) for '\\';
+// a line split by later commands becomes several pieces, linked in a circle through prev_piece and next_piece (a whole line links to itself)
+typedef struct segment_struct{
+    int x;
+    int y;
+    int dx;
+    int dy;
+    int length;
+    int prev_piece;
+    int next_piece;
+    unsigned long mark;
+} segment;
+
+// one segment listed in one bucket, next being the bucket's next entry (or -1)
+typedef struct bucket_entry_struct{
+    int segment;
+    int next;
+} bucket_entry;
+
+// the segments drawn on a canvas, with a grid of buckets listing every segment crossing each BUCKET_SIZE square of cells
+// (buckets[by][bx] is the first entry of the square from column bx * BUCKET_SIZE and row by * BUCKET_SIZE, or -1);
+// entries no longer used are kept in a list from free_entry for the next ones needed
+typedef struct segment_index_struct{
+    segment* segments;
+    int num_segments;
+    int segment_capacity;
+    bucket_entry* entries;
+    int num_entries;
+    int entry_capacity;
+    int free_entry;
+    int num_free_entries;
+    int** buckets;
+    int bucket_rows;
+    int bucket_cols;
+} segment_index;
+
+// a change to the cells of a canvas, named by its command: 'a' or 'd' adds or deletes the row y (selection 'r') or column x (selection 'c'),
+// 'r' keeps only the first y rows and x columns and 'e' erases the cell (x, y)
+typedef struct segment_edit_struct{
+    char command;
+    char selection;
+    int x;
+    int y;
+} segment_edit;
+
+segment create_segment(int x, int y, int dx, int dy, int length);
+segment create_line_segment(int x1, int y1, int x2, int y2);
+segment_edit create_segment_edit(char command, char selection, int x, int y);
+char segment_glyph(segment line);
+bool segment_covers(segment line, int x, int y);
+segment_index create_segment_index();
+bool copy_segment_index(segment_index* copy, segment_index* sourceIndex);
+void free_segment_index(segment_index* index);
+bool resize_bucket_grid(segment_index* index, int numRows, int numCols);
+size_t segment_index_footprint(segment_index* index, int numRows, int numCols);
+size_t add_segment_footprint(segment_index* index, segment line);
+bool make_room_for_segment(segment_index* index, segment line);
+void add_segment(segment_index* index, segment line);
+size_t edit_segments_footprint(segment_index* index, segment_edit edit, int numRows, int numCols);
+bool edit_segments(segment_index* index, segment_edit edit, int numRows, int numCols);
+int find_segments(segment_index* index, int xLow, int yLow, int xHigh, int yHigh, segment** found);
+int find_lines(segment_index* index, int x, int y, segment** pieces);
+void remove_lines(segment_index* index, int x, int y);
+char glyph_at(segment_index* index, int x, int y);
+
+#endif